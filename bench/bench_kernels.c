@@ -0,0 +1,272 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "img_editing.h"
+#include "stb_image.h"
+#include "stb_image_write.h"
+#include "synthetic.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/*
+ * Microbenchmarks dos kernels do editor
+ *
+ * As imagens são sintéticas e geradas em memória, sem disco: cada kernel
+ * (filtros, cadeia de filtros, decodificação e codificação) é medido
+ * isoladamente em cada resolução. Após as execuções de aquecimento, cada
+ * iteração é cronometrada e o relatório usa a mediana, menos sensível a
+ * interrupções do que a média.
+ *
+ * Uso: bench_kernels [--warmup N] [--iterations N] [--quality N]
+ */
+
+#define DEFAULT_WARMUP 2
+#define DEFAULT_ITERATIONS 10
+#define BENCH_QUALITY 90
+
+typedef struct
+{
+    int width;
+    int height;
+} Resolution;
+
+static const Resolution resolutions[] = {
+    {256, 256},
+    {1280, 720},
+    {1920, 1080},
+    {3840, 2160},
+};
+
+/*
+ * Entrada comum aos kernels de uma resolução
+ */
+typedef struct
+{
+    int width;
+    int height;
+    unsigned char *rgb;       // Imagem original
+    unsigned char *scratch;   // Cópia que os filtros modificam
+    unsigned char *jpeg;      // Imagem codificada (entrada da decodificação)
+    size_t jpeg_size;
+    unsigned char *png;
+    size_t png_size;
+    const Transform *transform;
+    int quality;
+} BenchInput;
+
+typedef void (*KernelFunction)(BenchInput *input);
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+// Ciclos do contador de tempo do processador (0 fora de x86)
+static uint64_t now_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Saída do codificador descartada: mede só a codificação
+static void discard_output(void *context, void *data, int size)
+{
+    (void)data;
+    *(size_t *)context += (size_t)size;
+}
+
+typedef struct
+{
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+} GrowBuffer;
+
+static void append_output(void *context, void *data, int size)
+{
+    GrowBuffer *buffer = context;
+    if (buffer->size + (size_t)size > buffer->capacity)
+    {
+        size_t capacity = buffer->capacity ? buffer->capacity * 2 : 65536;
+        while (capacity < buffer->size + (size_t)size)
+            capacity *= 2;
+        unsigned char *grown = realloc(buffer->data, capacity);
+        if (!grown)
+            return;
+        buffer->data = grown;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->size, data, (size_t)size);
+    buffer->size += (size_t)size;
+}
+
+static void kernel_transform(BenchInput *input)
+{
+    apply_transform(input->scratch, input->width, input->height, input->transform);
+}
+
+static void kernel_encode(BenchInput *input)
+{
+    size_t size = 0;
+    stbi_write_jpg_to_func(discard_output, &size, input->width, input->height, 3, input->rgb,
+                           input->quality);
+}
+
+static void kernel_decode_jpeg(BenchInput *input)
+{
+    int width, height, channels;
+    unsigned char *img = stbi_load_from_memory(input->jpeg, (int)input->jpeg_size, &width, &height,
+                                               &channels, 3);
+    stbi_image_free(img);
+}
+
+static void kernel_decode_png(BenchInput *input)
+{
+    int width, height, channels;
+    unsigned char *img = stbi_load_from_memory(input->png, (int)input->png_size, &width, &height, &channels, 3);
+    stbi_image_free(img);
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * @brief Mede um kernel: aquecimento, iterações cronometradas e mediana
+ *
+ * Os filtros modificam a imagem; antes de cada iteração a cópia de
+ * trabalho é restaurada, fora da medição.
+ */
+static void run_kernel(const char *name, KernelFunction kernel, BenchInput *input, int warmup,
+                       int iterations)
+{
+    size_t image_bytes = (size_t)input->width * input->height * 3;
+    uint64_t *times = malloc(iterations * sizeof(uint64_t));
+    uint64_t *cycles = malloc(iterations * sizeof(uint64_t));
+    if (!times || !cycles)
+    {
+        free(times);
+        free(cycles);
+        return;
+    }
+
+    for (int i = 0; i < warmup + iterations; i++)
+    {
+        memcpy(input->scratch, input->rgb, image_bytes);
+        uint64_t start_cycles = now_cycles();
+        uint64_t start = now_ns();
+        kernel(input);
+        uint64_t end = now_ns();
+        uint64_t end_cycles = now_cycles();
+        if (i >= warmup)
+        {
+            times[i - warmup] = end - start;
+            cycles[i - warmup] = end_cycles - start_cycles;
+        }
+    }
+
+    qsort(times, iterations, sizeof(uint64_t), compare_u64);
+    qsort(cycles, iterations, sizeof(uint64_t), compare_u64);
+    double pixels = (double)input->width * input->height;
+    uint64_t median = times[iterations / 2];
+    char resolution[32];
+    snprintf(resolution, sizeof(resolution), "%dx%d", input->width, input->height);
+    printf("%-18s %-10s %10.3f %10.1f", name, resolution, median / 1e6,
+           median ? pixels * 1e3 / median : 0);
+    if (cycles[iterations / 2])
+        printf(" %12.2f\n", cycles[iterations / 2] / pixels);
+    else
+        printf(" %12s\n", "-");
+
+    free(times);
+    free(cycles);
+}
+
+static int parse_count(const char *value, int minimum)
+{
+    char *end;
+    long count = strtol(value, &end, 10);
+    return *end || count < minimum ? -1 : (int)count;
+}
+
+int main(int argc, char **argv)
+{
+    int warmup = DEFAULT_WARMUP;
+    int iterations = DEFAULT_ITERATIONS;
+    int quality = BENCH_QUALITY;
+    for (int i = 1; i < argc; i++)
+    {
+        int *target = strcmp(argv[i], "--warmup") == 0       ? &warmup
+                      : strcmp(argv[i], "--iterations") == 0 ? &iterations
+                      : strcmp(argv[i], "--quality") == 0    ? &quality
+                                                             : NULL;
+        if (!target || i + 1 == argc || (*target = parse_count(argv[++i], target == &warmup ? 0 : 1)) < 0 ||
+            quality > 100)
+        {
+            fprintf(stderr, "Uso: %s [--warmup N] [--iterations N] [--quality 1-100]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Um kernel por filtro e a cadeia mais longa usada na prática
+    static const char *const filters[] = {"grayscale", "red", "green", "blue", "invert", "grayscale,invert"};
+    int filter_count = sizeof(filters) / sizeof(filters[0]);
+    Transform transforms[sizeof(filters) / sizeof(filters[0])];
+    for (int f = 0; f < filter_count; f++)
+        parse_transform(filters[f], quality, &transforms[f]);
+
+    printf("Aquecimento: %d, iterações: %d, qualidade JPEG: %d (mediana das iterações)\n\n", warmup,
+           iterations, quality);
+    printf("%-18s %-10s %10s %10s %12s\n", "Kernel", "Resolução", "ms", "MP/s", "ciclos/pixel");
+
+    for (size_t r = 0; r < sizeof(resolutions) / sizeof(resolutions[0]); r++)
+    {
+        BenchInput input = {0};
+        input.width = resolutions[r].width;
+        input.height = resolutions[r].height;
+        input.quality = quality;
+        input.rgb = synthetic_image(input.width, input.height, 0);
+        input.scratch = malloc((size_t)input.width * input.height * 3);
+        GrowBuffer jpeg = {0}, png = {0};
+        if (!input.rgb || !input.scratch ||
+            !stbi_write_jpg_to_func(append_output, &jpeg, input.width, input.height, 3, input.rgb, quality) ||
+            !stbi_write_png_to_func(append_output, &png, input.width, input.height, 3, input.rgb,
+                                    input.width * 3))
+        {
+            fprintf(stderr, "Falha ao gerar a imagem %dx%d\n", input.width, input.height);
+            return 1;
+        }
+        input.jpeg = jpeg.data;
+        input.jpeg_size = jpeg.size;
+        input.png = png.data;
+        input.png_size = png.size;
+
+        for (int f = 0; f < filter_count; f++)
+        {
+            input.transform = &transforms[f];
+            run_kernel(filters[f], kernel_transform, &input, warmup, iterations);
+        }
+        run_kernel("decode jpeg", kernel_decode_jpeg, &input, warmup, iterations);
+        run_kernel("decode png", kernel_decode_png, &input, warmup, iterations);
+        run_kernel("encode jpeg", kernel_encode, &input, warmup, iterations);
+        printf("\n");
+
+        free(input.rgb);
+        free(input.scratch);
+        free(input.jpeg);
+        free(input.png);
+    }
+    return 0;
+}
@@ -0,0 +1,442 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "affinity.h"
+#include "stb_image_write.h"
+#include "synthetic.h"
+
+/*
+ * Benchmark de escalabilidade de ponta a ponta
+ *
+ * Executa o editor completo (leitura, decodificação, filtros, codificação e
+ * gravação) sobre cada corpus, variando o número de threads e o filtro, e
+ * relata imagens/s, MP/s, speedup e eficiência paralela em relação a uma
+ * thread. Cada execução é um processo novo de `bin/editor --stats json`.
+ *
+ * Cache frio: antes de cada execução as páginas das imagens de entrada são
+ * descartadas do cache (posix_fadvise DONTNEED, sem exigir root).
+ * Cache quente: uma execução descartada carrega as imagens antes das medidas.
+ *
+ * Uso: bench_scaling [--editor CAMINHO] [--corpus DIR]... [--synthetic N]
+ *                    [--threads 1,2,4] [--filter NOMES]... [--repeat N]
+ *                    [--cache cold|warm|both] [--format text|csv]
+ */
+
+#define MAX_ITEMS 32
+#define DEFAULT_SYNTHETIC 64
+#define DEFAULT_REPEAT 3
+#define SYNTHETIC_QUALITY 90
+
+typedef enum
+{
+    CACHE_COLD,
+    CACHE_WARM,
+} CacheMode;
+
+static const char *const cache_names[] = {"fria", "quente"};
+
+typedef struct
+{
+    const char *editor;
+    const char *corpora[MAX_ITEMS + 1]; // + corpus sintético
+    int corpus_count;
+    int synthetic;
+    int threads[MAX_ITEMS];
+    int thread_count;
+    const char *filters[MAX_ITEMS];
+    int filter_count;
+    int repeat;
+    int cold;
+    int warm;
+    int csv;
+} BenchOptions;
+
+/*
+ * Resultado de uma execução do editor, lido do resumo JSON
+ */
+typedef struct
+{
+    int processed;
+    int failed;
+    double pixels;
+    double elapsed;
+} RunResult;
+
+// Resoluções do corpus sintético, alternadas entre as imagens
+static const int synthetic_sizes[][2] = {
+    {640, 480},
+    {1280, 720},
+    {1920, 1080},
+    {2592, 1944},
+};
+
+static int remove_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+    (void)st;
+    (void)flag;
+    (void)ftw;
+    remove(path);
+    return 0;
+}
+
+static void remove_tree(const char *path)
+{
+    nftw(path, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+/**
+ * @brief Gera o corpus sintético em `dir`, com resoluções variadas
+ * @return 1 se sucesso, 0 se falha
+ */
+static int generate_corpus(const char *dir, int count)
+{
+    char path[4096];
+    for (int i = 0; i < count; i++)
+    {
+        int width = synthetic_sizes[i % 4][0];
+        int height = synthetic_sizes[i % 4][1];
+        unsigned char *rgb = synthetic_image(width, height, (unsigned int)i);
+        snprintf(path, sizeof(path), "%s/synthetic%04d.jpg", dir, i);
+        int success = rgb && stbi_write_jpg(path, width, height, 3, rgb, SYNTHETIC_QUALITY);
+        free(rgb);
+        if (!success)
+            return 0;
+    }
+    return 1;
+}
+
+/*
+ * Descarta do cache de páginas o conteúdo das imagens do corpus, para que a
+ * próxima execução as leia do disco
+ */
+static void evict_corpus(const char *dir)
+{
+    DIR *d = opendir(dir);
+    if (!d)
+        return;
+    char path[4096];
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL)
+    {
+        if (entry->d_name[0] == '.')
+            continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            continue;
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+    closedir(d);
+}
+
+// Valor numérico de `"key":` na linha JSON, ou -1 se ausente
+static double json_number(const char *json, const char *key)
+{
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char *found = strstr(json, pattern);
+    return found ? strtod(found + strlen(pattern), NULL) : -1;
+}
+
+/**
+ * @brief Executa o editor uma vez e lê o resumo JSON da saída padrão
+ *
+ * As mensagens do editor (stderr) são descartadas
+ *
+ * @return 1 se o editor terminou com status 0 ou 2 (falha parcial), 0 caso contrário
+ */
+static int run_editor(const BenchOptions *opts, const char *corpus, const char *output,
+                      const char *filter, int threads, RunResult *result)
+{
+    int pipe_fds[2];
+    if (pipe(pipe_fds) != 0)
+        return 0;
+
+    char thread_arg[16];
+    snprintf(thread_arg, sizeof(thread_arg), "%d", threads);
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+        return 0;
+    }
+    if (pid == 0)
+    {
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(pipe_fds[1], STDOUT_FILENO);
+        if (null_fd >= 0)
+            dup2(null_fd, STDERR_FILENO);
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+        execl(opts->editor, opts->editor, "--input", corpus, "-o", output, "-f", filter, "-t", thread_arg,
+              "--stats", "json", (char *)NULL);
+        _exit(127);
+    }
+
+    close(pipe_fds[1]);
+    char json[1024];
+    size_t used = 0;
+    ssize_t n;
+    while ((n = read(pipe_fds[0], json + used, sizeof(json) - 1 - used)) > 0)
+        used += (size_t)n;
+    json[used] = 0;
+    close(pipe_fds[0]);
+
+    int status;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+        (WEXITSTATUS(status) != 0 && WEXITSTATUS(status) != 2))
+        return 0;
+
+    result->processed = (int)json_number(json, "processed");
+    result->failed = (int)json_number(json, "failed");
+    result->pixels = json_number(json, "pixels");
+    result->elapsed = json_number(json, "elapsed_s");
+    return result->processed >= 0 && result->elapsed >= 0;
+}
+
+static int compare_elapsed(const void *a, const void *b)
+{
+    double x = ((const RunResult *)a)->elapsed;
+    double y = ((const RunResult *)b)->elapsed;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * @brief Mede uma combinação corpus/filtro/cache/threads: mediana de `repeat` execuções
+ */
+static int measure(const BenchOptions *opts, const char *corpus, const char *output, const char *filter,
+                   CacheMode cache, int threads, RunResult *median)
+{
+    RunResult runs[MAX_ITEMS];
+    for (int r = 0; r < opts->repeat; r++)
+    {
+        if (cache == CACHE_COLD)
+            evict_corpus(corpus);
+        if (!run_editor(opts, corpus, output, filter, threads, &runs[r]))
+            return 0;
+    }
+    qsort(runs, opts->repeat, sizeof(RunResult), compare_elapsed);
+    *median = runs[opts->repeat / 2];
+    return 1;
+}
+
+static void print_row(const BenchOptions *opts, const char *corpus, const char *filter, CacheMode cache,
+                      int threads, const RunResult *result, const RunResult *baseline)
+{
+    double elapsed = result->elapsed > 0 ? result->elapsed : 1e-9;
+    double images_per_s = result->processed / elapsed;
+    double megapixels_per_s = result->pixels / 1e6 / elapsed;
+    double speedup = baseline->elapsed > 0 ? baseline->elapsed / elapsed : 0;
+    double efficiency = speedup / threads * 100;
+    if (opts->csv)
+        printf("%s,\"%s\",%s,%d,%d,%.1f,%.3f,%.2f,%.2f,%.2f,%.1f\n", corpus, filter,
+               cache == CACHE_COLD ? "cold" : "warm", threads, result->processed, result->pixels / 1e6,
+               result->elapsed, images_per_s, megapixels_per_s, speedup, efficiency);
+    else
+        printf("%-18s %-7s %7d %10.2f %9.1f %8.2fx %9.0f%%%s\n", filter, cache_names[cache], threads,
+               images_per_s, megapixels_per_s, speedup, efficiency, result->failed > 0 ? "  (falhas)" : "");
+}
+
+/*
+ * Lista de inteiros separados por vírgula (ex.: "1,2,4,8")
+ */
+static int parse_threads(char *list, BenchOptions *opts)
+{
+    opts->thread_count = 0;
+    for (char *item = strtok(list, ","); item; item = strtok(NULL, ","))
+    {
+        char *end;
+        long value = strtol(item, &end, 10);
+        if (*end || value < 1 || value > 4096 || opts->thread_count == MAX_ITEMS)
+            return 0;
+        opts->threads[opts->thread_count++] = (int)value;
+    }
+    return opts->thread_count > 0;
+}
+
+// Potências de 2 até o número de CPUs, mais o próprio número de CPUs
+static void default_threads(BenchOptions *opts)
+{
+    int cpus = available_cpus();
+    for (int t = 1; t < cpus && opts->thread_count < MAX_ITEMS - 1; t *= 2)
+        opts->threads[opts->thread_count++] = t;
+    opts->threads[opts->thread_count++] = cpus;
+}
+
+static int parse_options(int argc, char **argv, BenchOptions *opts)
+{
+    memset(opts, 0, sizeof(*opts));
+    opts->editor = "bin/editor";
+    opts->synthetic = DEFAULT_SYNTHETIC;
+    opts->repeat = DEFAULT_REPEAT;
+    opts->cold = opts->warm = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *name = argv[i];
+        char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!value)
+            return 0;
+        i++;
+        char *end;
+        if (strcmp(name, "--editor") == 0)
+            opts->editor = value;
+        else if (strcmp(name, "--corpus") == 0 && opts->corpus_count < MAX_ITEMS)
+            opts->corpora[opts->corpus_count++] = value;
+        else if (strcmp(name, "--synthetic") == 0)
+        {
+            opts->synthetic = (int)strtol(value, &end, 10);
+            if (*end || opts->synthetic < 0)
+                return 0;
+        }
+        else if (strcmp(name, "--threads") == 0)
+        {
+            if (!parse_threads(value, opts))
+                return 0;
+        }
+        else if (strcmp(name, "--filter") == 0 && opts->filter_count < MAX_ITEMS)
+            opts->filters[opts->filter_count++] = value;
+        else if (strcmp(name, "--repeat") == 0)
+        {
+            opts->repeat = (int)strtol(value, &end, 10);
+            if (*end || opts->repeat < 1 || opts->repeat > MAX_ITEMS)
+                return 0;
+        }
+        else if (strcmp(name, "--cache") == 0)
+        {
+            opts->cold = strcmp(value, "cold") == 0 || strcmp(value, "both") == 0;
+            opts->warm = strcmp(value, "warm") == 0 || strcmp(value, "both") == 0;
+            if (!opts->cold && !opts->warm)
+                return 0;
+        }
+        else if (strcmp(name, "--format") == 0)
+        {
+            if (strcmp(value, "csv") == 0)
+                opts->csv = 1;
+            else if (strcmp(value, "text") != 0)
+                return 0;
+        }
+        else
+            return 0;
+    }
+
+    if (opts->corpus_count == 0)
+        opts->corpora[opts->corpus_count++] = "test_images";
+    if (opts->filter_count == 0)
+    {
+        opts->filters[opts->filter_count++] = "grayscale";
+        opts->filters[opts->filter_count++] = "grayscale,invert";
+    }
+    if (opts->thread_count == 0)
+        default_threads(opts);
+    return 1;
+}
+
+/**
+ * @brief Varre filtros, modos de cache e threads sobre um corpus
+ * @return 1 se todas as execuções terminaram, 0 se alguma falhou
+ */
+static int bench_corpus(const BenchOptions *opts, const char *corpus, const char *label, const char *output)
+{
+    if (!opts->csv)
+        printf("\n======= %s =======\n\n%-18s %-7s %7s %10s %9s %9s %10s\n", label, "Filtro", "Cache",
+               "Threads", "imagens/s", "MP/s", "speedup", "eficiência");
+
+    for (int f = 0; f < opts->filter_count; f++)
+    {
+        for (CacheMode cache = CACHE_COLD; cache <= CACHE_WARM; cache++)
+        {
+            if ((cache == CACHE_COLD && !opts->cold) || (cache == CACHE_WARM && !opts->warm))
+                continue;
+
+            // Execução descartada: carrega o corpus no cache e cria a saída
+            RunResult warmup, baseline, result;
+            if (cache == CACHE_WARM && !run_editor(opts, corpus, output, opts->filters[f], 1, &warmup))
+                return 0;
+            if (!measure(opts, corpus, output, opts->filters[f], cache, 1, &baseline))
+                return 0;
+            for (int t = 0; t < opts->thread_count; t++)
+            {
+                if (opts->threads[t] == 1)
+                    result = baseline;
+                else if (!measure(opts, corpus, output, opts->filters[f], cache, opts->threads[t], &result))
+                    return 0;
+                print_row(opts, label, opts->filters[f], cache, opts->threads[t], &result, &baseline);
+                fflush(stdout);
+            }
+        }
+    }
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions opts;
+    if (!parse_options(argc, argv, &opts))
+    {
+        fprintf(stderr, "Uso: %s [--editor CAMINHO] [--corpus DIR]... [--synthetic N] [--threads 1,2,4]\n"
+                        "       [--filter NOMES]... [--repeat N] [--cache cold|warm|both] [--format text|csv]\n",
+                argv[0]);
+        return 1;
+    }
+    if (access(opts.editor, X_OK) != 0)
+    {
+        fprintf(stderr, "Editor não encontrado: %s (rode make)\n", opts.editor);
+        return 1;
+    }
+
+    // Corpus sintético e saídas ficam num diretório temporário, removido ao final
+    char work_dir[] = "/tmp/bench_scaling.XXXXXX";
+    if (!mkdtemp(work_dir))
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+    char synthetic_dir[sizeof(work_dir) + 16];
+    char output_dir[sizeof(work_dir) + 16];
+    snprintf(synthetic_dir, sizeof(synthetic_dir), "%s/synthetic", work_dir);
+    snprintf(output_dir, sizeof(output_dir), "%s/output", work_dir);
+
+    int status = 0;
+    if (opts.synthetic > 0)
+    {
+        fprintf(stderr, "Gerando corpus sintético com %d imagens...\n", opts.synthetic);
+        if (mkdir(synthetic_dir, 0755) != 0 || !generate_corpus(synthetic_dir, opts.synthetic))
+        {
+            fprintf(stderr, "Falha ao gerar o corpus sintético\n");
+            remove_tree(work_dir);
+            return 1;
+        }
+        opts.corpora[opts.corpus_count++] = synthetic_dir;
+    }
+
+    if (opts.csv)
+        printf("corpus,filter,cache,threads,images,megapixels,elapsed_s,images_per_s,megapixels_per_s,"
+               "speedup,efficiency_pct\n");
+    else
+        printf("Mediana de %d execuções por ponto; speedup e eficiência em relação a 1 thread (%d CPUs)\n",
+               opts.repeat, available_cpus());
+
+    for (int c = 0; c < opts.corpus_count; c++)
+    {
+        int synthetic = opts.synthetic > 0 && c == opts.corpus_count - 1;
+        if (!bench_corpus(&opts, opts.corpora[c], synthetic ? "sintético" : opts.corpora[c], output_dir))
+        {
+            fprintf(stderr, "Falha ao executar %s sobre %s\n", opts.editor, opts.corpora[c]);
+            status = 1;
+            break;
+        }
+        remove_tree(output_dir);
+    }
+    remove_tree(work_dir);
+    return status;
+}
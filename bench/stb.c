@@ -0,0 +1,19 @@
+#include "buffer_pool.h"
+
+/*
+ * Implementação do stb para os benchmarks
+ *
+ * A biblioteca compila o stb como estático em img_editing.c, sem exportar
+ * stbi_*; aqui ele é compilado com os mesmos alocadores, para que a
+ * decodificação e a codificação medidas usem o pool de buffers do editor.
+ */
+#define STBI_MALLOC(size) pool_malloc(size)
+#define STBI_REALLOC_SIZED(ptr, old_size, new_size) pool_realloc(ptr, old_size, new_size)
+#define STBI_FREE(ptr) pool_free(ptr)
+#define STBIW_MALLOC(size) pool_malloc(size)
+#define STBIW_REALLOC_SIZED(ptr, old_size, new_size) pool_realloc(ptr, old_size, new_size)
+#define STBIW_FREE(ptr) pool_free(ptr)
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
@@ -0,0 +1,28 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include "synthetic.h"
+
+/*
+ * Gradientes com ruído, para que o codificador JPEG não trabalhe sobre
+ * áreas totalmente uniformes; a semente muda o ruído e a fase do padrão
+ */
+unsigned char *synthetic_image(int width, int height, unsigned int seed)
+{
+    unsigned char *rgb = malloc((size_t)width * height * 3);
+    if (!rgb)
+        return NULL;
+    uint32_t state = 12345 + seed;
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            state = state * 1103515245 + 12345;
+            int noise = (int)((state >> 16) & 31) - 16;
+            unsigned char *p = rgb + ((size_t)y * width + x) * 3;
+            p[0] = (unsigned char)(x * 255 / width + seed * 37);
+            p[1] = (unsigned char)(y * 255 / height + seed * 11);
+            p[2] = (unsigned char)((x + y + noise) & 255);
+        }
+    }
+    return rgb;
+}
@@ -0,0 +1,10 @@
+#ifndef SYNTHETIC_H
+#define SYNTHETIC_H
+
+/*
+ * Imagem RGB sintética e determinística usada pelos benchmarks: mesma
+ * semente, mesma imagem (liberar com free)
+ */
+unsigned char *synthetic_image(int width, int height, unsigned int seed);
+
+#endif
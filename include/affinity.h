@@ -0,0 +1,14 @@
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+// Requer _GNU_SOURCE definido antes dos includes (cpu_set_t)
+#include <sched.h>
+
+int parse_cpu_list(const char *text, cpu_set_t *set);
+int allowed_cpus(void);
+int available_cpus(void);
+int affinity_plan(const char *spec, int num_threads, int *cpus);
+int affinity_node_cpus(int cpu, cpu_set_t *set);
+int affinity_node_groups(const int *cpus, int num_threads, int *groups);
+
+#endif
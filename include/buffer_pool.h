@@ -0,0 +1,21 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <stddef.h>
+
+/*
+ * Pool de buffers por thread, usado pelos alocadores do stb_image e do
+ * stb_image_write (STBI_MALLOC/STBI_REALLOC_SIZED/STBI_FREE)
+ *
+ * Buffers grandes são agrupados em classes de tamanho (potências de 2) e,
+ * ao serem liberados, ficam guardados na thread para a próxima imagem em vez
+ * de voltarem ao malloc, até um limite de bytes guardados comum a todas as
+ * threads. Buffers a partir de 2 MB são arredondados para múltiplos de 2 MB,
+ * em páginas enormes, e reaproveitados pelo tamanho exato. Buffers pequenos
+ * usam o malloc diretamente.
+ */
+void *pool_malloc(size_t size);
+void *pool_realloc(void *ptr, size_t old_size, size_t new_size);
+void pool_free(void *ptr);
+
+#endif
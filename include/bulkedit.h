@@ -0,0 +1,61 @@
+#ifndef BULKEDIT_H
+#define BULKEDIT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * libbulkedit - API para usar o editor dentro de outros programas
+ *
+ * Um pool de threads processa trabalhos submetidos por caminho (lê e grava
+ * arquivos) ou por buffer (bytes codificados em memória, resultado em
+ * memória). Cada submissão retorna um identificador que deve ser consultado
+ * com bulkedit_poll ou bulkedit_wait; ao informar a conclusão, o trabalho é
+ * liberado e o identificador deixa de ser válido.
+ *
+ * Filtros: "grayscale", "red", "green", "blue" e "invert", ou vários
+ * separados por vírgula, aplicados em ordem (ex.: "grayscale,invert"). A
+ * saída é sempre JPEG. As funções podem ser chamadas de várias threads ao mesmo tempo.
+ */
+typedef struct BulkEditPool BulkEditPool;
+
+// A libbulkedit.so é compilada com -fvisibility=hidden: só estas funções são exportadas
+#define BULKEDIT_API __attribute__((visibility("default")))
+
+/*
+ * Resultado de um trabalho concluído
+ */
+typedef struct
+{
+    int success;            // 1 se a imagem foi processada
+    int64_t pixels;         // Largura * altura da imagem decodificada
+    unsigned char *output;  // JPEG gerado (só trabalhos por buffer); liberar com bulkedit_free
+    size_t output_size;
+} BulkEditResult;
+
+// Notificação de conclusão, chamada em uma thread do pool
+typedef void (*BulkEditCallback)(int64_t job, const BulkEditResult *result, void *context);
+
+BULKEDIT_API BulkEditPool *bulkedit_pool_create(int num_threads);
+BULKEDIT_API void bulkedit_pool_destroy(BulkEditPool *pool);
+BULKEDIT_API int bulkedit_pool_set_quality(BulkEditPool *pool, int quality);
+BULKEDIT_API int bulkedit_pool_set_active(BulkEditPool *pool, int active);
+
+BULKEDIT_API int64_t bulkedit_submit_path(BulkEditPool *pool, const char *input_path,
+                                          const char *output_path, const char *filter);
+BULKEDIT_API int64_t bulkedit_submit_buffer(BulkEditPool *pool, const void *input, size_t input_size,
+                                            const char *filter);
+BULKEDIT_API int64_t bulkedit_submit_path_callback(BulkEditPool *pool, const char *input_path,
+                                                   const char *output_path, const char *filter,
+                                                   BulkEditCallback callback, void *context);
+BULKEDIT_API int64_t bulkedit_submit_buffer_callback(BulkEditPool *pool, const void *input,
+                                                     size_t input_size, const char *filter,
+                                                     BulkEditCallback callback, void *context);
+BULKEDIT_API int bulkedit_poll(BulkEditPool *pool, int64_t job, BulkEditResult *result);
+BULKEDIT_API int bulkedit_wait(BulkEditPool *pool, int64_t job, BulkEditResult *result);
+
+BULKEDIT_API int bulkedit_transform_buffer(const void *input, size_t input_size, const char *filter,
+                                           int quality, unsigned char **output, size_t *output_size);
+BULKEDIT_API void bulkedit_free(void *ptr);
+
+#endif
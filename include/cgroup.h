@@ -0,0 +1,7 @@
+#ifndef CGROUP_H
+#define CGROUP_H
+
+double cgroup_cpu_quota(void);
+int cgroup_cpuset_count(void);
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include <pthread.h>
+#include "queue.h"
+
+/*
+ * Controlador de concorrência
+ *
+ * Periodicamente relê as CPUs disponíveis (cota e cpuset do cgroup), que
+ * limitam as threads ativas. Com hill_climb (--threads auto), também mede a
+ * vazão da fila em janelas curtas e ajusta por subida de encosta quantas
+ * trabalhadoras ficam ativas; sem ele, mantém uma thread ativa por CPU.
+ */
+typedef struct
+{
+    Queue *queue;
+    int max_threads;    // Threads criadas
+    int hill_climb;     // Ajusta pela vazão (senão, segue as CPUs disponíveis)
+    int threads_per_cpu; // Teto de threads ativas por CPU disponível
+    int cpus;           // CPUs disponíveis na última verificação
+    int ceiling;        // Máximo de threads ativas para as CPUs atuais
+    int active;         // Limite atual de threads ativas
+    int peak;           // Maior limite usado
+    int adjustments;    // Quantidade de mudanças de limite
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond; // Acorda o controlador antes do fim da janela ao encerrar
+    int stop;
+} Controller;
+
+int controller_start(Controller *controller, Queue *queue, int max_threads, int hill_climb,
+                     int threads_per_cpu);
+void controller_stop(Controller *controller);
+
+#endif
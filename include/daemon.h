@@ -0,0 +1,6 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+int run_daemon(const char *socket_path, int num_threads);
+
+#endif
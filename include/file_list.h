@@ -0,0 +1,9 @@
+#ifndef FILE_LIST_H
+#define FILE_LIST_H
+
+#include <stdio.h>
+#include "queue.h"
+
+int stream_file_list(Queue *queue, FILE *list, int delimiter, const char *edit_type, int queue_size);
+
+#endif
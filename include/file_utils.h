@@ -2,10 +2,30 @@
 #define FILE_UTILS_H
 
 #include <dirent.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <sys/stat.h>
 #include "img_editing.h"
 
 int is_image_file(const char *filename);
-ImagePath *scan_directory(const char *input_dir, const char *output_dir, int *count);
+ImagePath *scan_directory(PathTable *table, const char *input_dir, const char *output_dir, int *count);
 
-#endif
\ No newline at end of file
+// Ordenação da fila pelo custo estimado (maiores primeiro)
+void sort_largest_first(const PathTable *table, ImagePath *paths, int count);
+
+// Hash rápido não criptográfico (XXH64)
+uint64_t hash_bytes(const void *data, size_t len, uint64_t seed);
+int hash_file(const char *path, uint64_t *hash);
+
+// Deduplicação de entradas idênticas
+int dedup_images(const PathTable *table, ImagePath *paths, int count);
+int link_output(const char *source, const char *target);
+
+int make_dirs(const char *dir);
+
+// Leitura e gravação de arquivos inteiros (pool de I/O)
+unsigned char *read_file(const char *path, size_t *size);
+int write_file(const char *path, const unsigned char *data, size_t size);
+
+#endif
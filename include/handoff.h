@@ -0,0 +1,59 @@
+#ifndef HANDOFF_H
+#define HANDOFF_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "img_editing.h"
+
+/*
+ * Trabalho de processamento entregue pelo pool de I/O ao pool de processamento
+ *
+ * Fica na pilha da thread de I/O, que aguarda em `done_cond` até o resultado
+ * estar pronto; o número de trabalhos em andamento é limitado pelo número
+ * de threads de I/O
+ */
+typedef struct ComputeJob
+{
+    const unsigned char *input;  // Arquivo de entrada lido pela thread de I/O
+    size_t input_size;
+    const Transform *transform;
+    unsigned char *output;       // JPEG codificado pela thread de processamento
+    size_t output_size;
+    int width;                   // Dimensões da imagem decodificada (índice do --pack)
+    int height;
+    int64_t pixels;
+    int success;
+    int done;
+    pthread_cond_t *done_cond;   // Condição da thread de I/O dona do trabalho
+    struct ComputeJob *next;
+} ComputeJob;
+
+/*
+ * Fila de passagem entre os pools de I/O e de processamento
+ *
+ * 1. mutex - Exclusão mútua sobre a lista de trabalhos
+ * 2. job_cond - Threads de processamento esperam por trabalhos
+ * 3. done_cond de cada trabalho - Thread de I/O espera pelo resultado
+ */
+typedef struct
+{
+    ComputeJob *head;
+    ComputeJob *tail;
+    int closed;         // Sem novos trabalhos: threads de processamento terminam
+    int waiting;        // Trabalhos aguardando uma thread de processamento
+    int peak_waiting;   // Maior fila observada (pool de processamento saturado)
+
+    pthread_mutex_t mutex;
+    pthread_cond_t job_cond;
+} Handoff;
+
+void handoff_init(Handoff *handoff);
+void handoff_destroy(Handoff *handoff);
+void handoff_close(Handoff *handoff);
+
+int handoff_submit(Handoff *handoff, ComputeJob *job);
+ComputeJob *handoff_take(Handoff *handoff);
+void handoff_finish(Handoff *handoff, ComputeJob *job);
+
+#endif
@@ -1,9 +1,12 @@
 #ifndef IMG_EDITING_H
 #define IMG_EDITING_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <pthread.h>
 #include <time.h>
+#include "options.h"
+#include "queue.h"
 
 /*
  * Pixel (r,g,b) de 8 bits (0-255)
@@ -18,38 +21,21 @@ typedef struct
 // Tipo de função que realiza transformação em pixels
 typedef Pixel (*PixelTransformFunction)(Pixel);
 
-/*
- * Estrutura que mantém os caminhos de entrada e saída de uma imagem
- */
-typedef struct
-{
-    char input_path[512];
-    char output_path[512];
-} ImagePath;
+// Máximo de filtros encadeados em uma transformação
+#define MAX_FILTERS 8
+// Qualidade JPEG padrão (1-100)
+#define DEFAULT_QUALITY 100
 
 /*
- * Fila de imagens thread-safe com sincronização de processamento entre múltiplas threads
- *
- * Utiliza as seguintes estratégias:
- * 1. mutex - Garante exclusão mútua ao acessar a fila
- * 2. queue_cond - Variável de condição para sinalizar quando há/não há trabalho
- * 3. done_cond - Variável de condição para indicar conclusão do processamento
+ * Transformação aplicada a cada imagem: filtros em sequência (ex.:
+ * "grayscale,invert") e opções do codificador
  */
 typedef struct
 {
-    ImagePath *paths;   // Array com os caminhos das imagens
-    int size;           // Número de imagens
-    int current;        // Índice da próxima imagem a ser processada
-    int processed;      // Contador de imagens já processadas
-    int should_exit;    // Flag para indicar que as threads devem terminar
-    double total_time;  // Tempo total acumulado em segundos
-
-    pthread_mutex_t mutex;
-    // Define a espera das Threads trabalhadoras por imagens
-    pthread_cond_t queue_cond;
-    // Define a espera da Thread principal pela conclusão do processamento
-    pthread_cond_t done_cond;
-} Queue;
+    PixelTransformFunction filters[MAX_FILTERS];
+    int count;
+    int quality; // Qualidade JPEG da saída
+} Transform;
 
 /*
  * Estado compartilhado entre todas as threads do pool
@@ -57,14 +43,25 @@ typedef struct
 typedef struct
 {
     Queue queue;
-    PixelTransformFunction transform;
+    Transform transform;
+    const Transform *job_transforms; // Com --jobs: transformação de cada job (ImagePath.job)
     int total_processed;
+    const Options *opts;
+    struct Pack *pack; // Contêiner que recebe as saídas (--pack), ou NULL
 } SharedState;
 
 // Função de transformação de imagem
-int transform_image(const char *input_path, const char *output_path, PixelTransformFunction transform);
+int transform_image(const char *input_path, const char *output_path, const Transform *transform,
+                    int64_t *pixels);
+int transform_buffer(const unsigned char *input, size_t input_size, const Transform *transform,
+                     unsigned char **output, size_t *output_size, int *width, int *height,
+                     int64_t *pixels);
+int probe_image(const char *path, int *width, int *height);
+void apply_transform(unsigned char *img, int width, int height, const Transform *transform);
 
 // Filtros disponíveis
+PixelTransformFunction get_transform_function(const char *edit_type);
+int parse_transform(const char *spec, int quality, Transform *transform);
 Pixel grayscale(Pixel pixel);
 Pixel filter_red(Pixel pixel);
 Pixel filter_green(Pixel pixel);
@@ -0,0 +1,46 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include "img_editing.h"
+#include "manifest.h"
+
+// Máximo de jobs em um arquivo (limite do índice guardado em ImagePath.job)
+#define MAX_JOBS 65535
+
+/*
+ * Job do arquivo de jobs: um diretório processado com uma cadeia de filtros
+ */
+typedef struct
+{
+    char *input_dir;
+    char *output_dir;
+    char *filter;       // Cadeia de filtros, como em --filter
+    Transform transform;
+    int priority;       // Jobs de maior prioridade entram primeiro na fila
+    int line;           // Linha do arquivo (ordem entre prioridades iguais)
+
+    // Preenchidos ao montar a fila e ao final da execução
+    int start;          // Primeira imagem do job na fila
+    int count;          // Imagens do job na fila
+    int skipped;        // Imagens já atualizadas (modo incremental)
+    int processed;
+    int failed;
+    int error;          // Diretório de entrada inacessível
+    Manifest previous;
+    Manifest next;
+} Job;
+
+typedef struct
+{
+    Job *jobs;
+    int count;
+    Transform *transforms; // Transformação de cada job, indexada por ImagePath.job
+} JobSpec;
+
+int load_job_spec(const char *path, int quality, JobSpec *spec);
+void job_spec_free(JobSpec *spec);
+
+int queue_jobs(SharedState *state, JobSpec *spec);
+void finish_jobs(SharedState *state, JobSpec *spec);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef LOCK_STATS_H
+#define LOCK_STATS_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+/*
+ * Disputa do mutex e das condições da fila, contada por thread
+ */
+typedef struct
+{
+    const char *role;      // Papel da thread: "trabalhadora", "io", "principal", ...
+    int id;                // Índice da thread no seu papel
+    uint64_t acquisitions; // Vezes que a thread travou o mutex
+    uint64_t contended;    // Travas que encontraram o mutex ocupado
+    uint64_t wait_ns;      // Tempo bloqueado esperando o mutex
+    uint64_t wakeups;      // Retornos de pthread_cond_wait
+    uint64_t spurious;     // Retornos em que a condição esperada continuava falsa
+} LockStats;
+
+void lock_stats_enable(void);
+void lock_stats_set_thread(const char *role, int id);
+void lock_stats_lock(pthread_mutex_t *mutex);
+void lock_stats_wait(pthread_cond_t *cond, pthread_mutex_t *mutex, int *woken);
+int lock_stats_collect(LockStats **stats);
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef MANIFEST_H
+#define MANIFEST_H
+
+#include <stdint.h>
+#include "img_editing.h"
+
+// Nome do manifesto gravado dentro do diretório de saída
+#define MANIFEST_FILE ".manifest"
+// Maior chave de transformação (filtros e qualidade), com o terminador
+#define MANIFEST_CHAIN_SIZE 128
+
+/*
+ * Registro de uma saída já gerada: identifica a entrada pelo tamanho,
+ * data de modificação e (opcionalmente) hash do conteúdo, junto com a
+ * transformação aplicada (ver manifest_chain)
+ */
+typedef struct
+{
+    char *name;
+    int64_t size;
+    int64_t mtime_ns;
+    uint64_t hash;
+    int has_hash;
+    char *chain;    // Filtros e qualidade, ex.: "grayscale,invert:q90"
+} ManifestEntry;
+
+typedef struct
+{
+    ManifestEntry *entries;
+    int count;
+    int capacity;
+} Manifest;
+
+void manifest_chain(const Transform *transform, const char *filter, char *chain, size_t size);
+int manifest_load(Manifest *manifest, const char *output_dir);
+int manifest_save(const Manifest *manifest, const char *output_dir);
+void manifest_free(Manifest *manifest);
+
+int manifest_add(Manifest *manifest, const char *name, int64_t size, int64_t mtime_ns,
+                 uint64_t hash, int has_hash, const char *chain);
+
+int manifest_select_pending(const Manifest *previous, Manifest *next, const PathTable *table,
+                            ImagePath *paths, int count, const char *chain, int use_hash);
+void manifest_record_done(Manifest *next, const PathTable *table, const ImagePath *paths, int count,
+                          const char *chain);
+
+#endif
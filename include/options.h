@@ -0,0 +1,78 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+// Valores especiais do número de threads
+#define THREADS_ASK -1     // Pergunta ao usuário
+#define THREADS_AUTO 0     // Controlador ajusta pela vazão
+#define THREADS_DEFAULT -2 // Uma por CPU disponível (cota do cgroup), reavaliado
+
+// Ordem em que as imagens de um lote entram na fila
+typedef enum
+{
+    ORDER_LARGEST_FIRST, // Maior número de pixels primeiro (lido do cabeçalho)
+    ORDER_DIRECTORY,     // Ordem retornada pelo readdir
+} QueueOrder;
+
+// Formato das estatísticas finais
+typedef enum
+{
+    STATS_TEXT, // Relatório para leitura humana
+    STATS_JSON, // Resumo em uma linha JSON na saída padrão (relatórios vão para stderr)
+} StatsFormat;
+
+// Relatório do tempo gasto em cada etapa do processamento
+typedef enum
+{
+    TIMINGS_NONE, // Sem medição
+    TIMINGS_TEXT, // Tabela com os percentis de cada etapa
+    TIMINGS_JSON, // Uma linha JSON junto aos relatórios
+} TimingsFormat;
+
+// Enquadramento das imagens no modo fluxo (stdin -> stdout)
+typedef enum
+{
+    STREAM_NONE,   // Sem fluxo
+    STREAM_LENGTH, // Tamanho em 4 bytes big-endian seguido da imagem
+    STREAM_TAR,    // Um arquivo regular do tar por imagem
+} StreamFormat;
+
+/*
+ * Opções de execução informadas pela linha de comando
+ */
+typedef struct
+{
+    int incremental;  // Pula imagens cuja saída já está atualizada (manifesto)
+    int content_hash; // Valida o manifesto também pelo hash do conteúdo
+    int dedup;        // Processa uma única vez entradas com conteúdo idêntico
+    QueueOrder order; // Ordem das imagens na fila do modo em lote
+    int watch;        // Processa continuamente as imagens que chegam no diretório
+    int queue_size;   // Máximo de imagens aguardando na fila do modo contínuo
+    int debounce_ms;  // Espera após a última notificação de um arquivo
+    const char *file_list; // Lista de caminhos a processar ("-" para stdin)
+    int list_delimiter;    // Separador dos registros da lista ('\n' ou '\0')
+    int threads;      // Número de threads ou THREADS_ASK/THREADS_AUTO/THREADS_DEFAULT
+    const char *filter; // Filtro a aplicar (NULL = perguntar)
+    const char *affinity; // "compact", "scatter" ou lista de CPUs (NULL = sem fixar)
+    int io_threads;   // Threads dedicadas à leitura/gravação (0 = pool único)
+    const char *input_dir;  // Diretório de entrada (NULL = perguntar)
+    const char *output_dir; // Diretório de saída (NULL = <entrada>_<filtro>)
+    int quality;      // Qualidade JPEG da saída (1-100)
+    StatsFormat stats_format;
+    TimingsFormat timings;  // Mede cada etapa por imagem (leitura, decodificação, ...)
+    TimingsFormat lock_stats; // Conta a disputa da fila por thread (mesmos formatos de timings)
+    const char *trace;      // Linha do tempo trace-event gravada ao final (NULL = sem trace)
+    TimingsFormat perf;     // Contadores de hardware por etapa (mesmos formatos de timings)
+    const char *daemon_socket; // Socket Unix do modo daemon (NULL = sem daemon)
+    const char *job_file;   // Arquivo de jobs executados em um único pool (NULL = sem jobs)
+    StreamFormat stream;    // Lê imagens da entrada padrão e grava na saída padrão
+    int unordered;          // No fluxo, grava na ordem de conclusão em vez da de entrada
+    const char *tar_input;  // Tar lido em vez de um diretório (NULL = sem tar)
+    const char *tar_output; // Tar gravado em vez do diretório de saída (NULL = sem tar)
+    const char *pack;       // Contêiner de saída: arquivo de dados + índice (NULL = diretório)
+    const char *unpack;     // Contêiner a extrair para --output (NULL = sem extração)
+} Options;
+
+int parse_options(int argc, char **argv, Options *opts);
+void print_usage(const char *program);
+
+#endif
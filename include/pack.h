@@ -0,0 +1,47 @@
+#ifndef PACK_H
+#define PACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Tamanho fixo de cada registro do índice (e do cabeçalho, que ocupa o primeiro)
+#define PACK_RECORD_SIZE 256
+// Maior nome guardado em um registro, incluindo o NUL
+#define PACK_NAME_SIZE (PACK_RECORD_SIZE - 24)
+
+/*
+ * Registro do índice: uma imagem guardada no arquivo de dados
+ *
+ * O registro i fica em (i + 1) * PACK_RECORD_SIZE no índice; posições sem
+ * imagem (falhas) ficam zeradas e têm nome vazio
+ */
+typedef struct
+{
+    char name[PACK_NAME_SIZE];
+    uint64_t offset;  // Posição do JPEG no arquivo de dados
+    uint32_t length;  // Tamanho do JPEG
+    uint32_t width;
+    uint32_t height;
+    uint32_t reserved;
+} PackRecord;
+
+/*
+ * Contêiner de saída aberto para gravação
+ *
+ * As threads reservam a região de cada JPEG no arquivo de dados com um
+ * incremento atômico de `data_end` e a gravam com pwrite, sem trava
+ */
+typedef struct Pack
+{
+    int data_fd;
+    int index_fd;
+    uint64_t data_end;
+} Pack;
+
+int pack_create(Pack *pack, const char *path);
+int pack_append(Pack *pack, uint32_t record, const char *name, const unsigned char *data,
+                size_t size, int width, int height);
+int pack_finish(Pack *pack, uint32_t records);
+int pack_extract(const char *path, const char *output_dir, int *failed);
+
+#endif
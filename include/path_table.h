@@ -0,0 +1,44 @@
+#ifndef PATH_TABLE_H
+#define PATH_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Armazenamento compacto de caminhos
+ *
+ * Cada diretório é guardado uma única vez em uma tabela, e os nomes dos
+ * arquivos ficam em uma arena contígua de strings. Uma imagem referencia
+ * diretório e nome por índice/deslocamento, e o caminho completo só é
+ * montado quando necessário, em um buffer da thread que vai usá-lo.
+ *
+ * A arena pode ser realocada ao crescer, então os ponteiros devolvidos por
+ * path_table_name/path_table_dir só valem enquanto a tabela não é alterada.
+ * A tabela não é thread-safe: na fila, o acesso é protegido pelo mutex.
+ */
+typedef struct
+{
+    char **dirs;             // Diretórios distintos (entrada e saída)
+    uint32_t dir_count;
+    uint32_t dir_capacity;
+    uint32_t *dir_index;     // Tabela hash: posição -> índice + 1 em dirs (0 = vazia)
+    uint32_t dir_index_size; // Potência de 2, pelo menos o dobro de dir_capacity
+
+    char *names;             // Nomes dos arquivos terminados em '\0'
+    size_t names_size;
+    size_t names_capacity;
+} PathTable;
+
+void path_table_init(PathTable *table);
+void path_table_free(PathTable *table);
+void path_table_drop_names(PathTable *table, size_t count);
+
+int path_table_add_dir(PathTable *table, const char *dir, uint32_t *index);
+int path_table_add_name(PathTable *table, const char *name, uint32_t *offset);
+int path_table_add_path(PathTable *table, const char *path, uint32_t *dir, uint32_t *name);
+
+const char *path_table_dir(const PathTable *table, uint32_t index);
+const char *path_table_name(const PathTable *table, uint32_t offset);
+int path_table_join(const PathTable *table, uint32_t dir, uint32_t name, char *buffer, size_t size);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdint.h>
+#include "timing.h"
+
+/*
+ * Contadores de hardware lidos com perf_event_open em cada thread
+ */
+typedef enum
+{
+    COUNTER_CYCLES,        // Ciclos do processador
+    COUNTER_INSTRUCTIONS,  // Instruções executadas
+    COUNTER_LLC_MISSES,    // Faltas no último nível de cache
+    COUNTER_BRANCH_MISSES, // Desvios previstos incorretamente
+    COUNTER_COUNT,
+} Counter;
+
+/*
+ * Leitura dos contadores da thread em um instante
+ */
+typedef struct
+{
+    uint64_t value[COUNTER_COUNT];
+    uint64_t enabled[COUNTER_COUNT]; // Tempo com o contador ligado
+    uint64_t running[COUNTER_COUNT]; // Tempo realmente contando (multiplexação)
+} CounterSample;
+
+/*
+ * Soma dos contadores de uma etapa em todas as threads
+ */
+typedef struct
+{
+    uint64_t count;                  // Imagens medidas
+    int64_t pixels;
+    double value[COUNTER_COUNT];     // Estimados quando o kernel multiplexa os contadores
+    int available[COUNTER_COUNT];    // 0 se o contador não pôde ser aberto
+} StageCounters;
+
+void counters_enable(void);
+void counters_read(CounterSample *sample);
+void counters_record(Stage stage, const CounterSample *start, const CounterSample *end, int64_t pixels);
+int counters_collect(StageCounters stats[STAGE_COUNT]);
+const char *counter_name(Counter counter);
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "path_table.h"
+
+/*
+ * Imagem na fila: os caminhos de entrada e saída são referências para a
+ * PathTable da fila (diretório + nome) e são montados sob demanda
+ */
+typedef struct
+{
+    uint32_t input_dir;   // Índice do diretório de entrada na PathTable
+    uint32_t output_dir;  // Índice do diretório de saída na PathTable
+    uint32_t name;        // Deslocamento do nome do arquivo de entrada na arena
+    uint32_t output_name; // Deslocamento do nome do arquivo de saída na arena
+    int32_t width;        // Dimensões lidas do cabeçalho (0 se desconhecidas)
+    int32_t height;
+    int32_t dup_of;       // Índice da imagem idêntica que será processada (deduplicação)
+    uint8_t has_hash;
+    uint8_t done;         // Marcado pela thread trabalhadora quando a saída foi gravada
+    uint16_t job;         // Job do arquivo de jobs (--jobs) ao qual a imagem pertence
+    int64_t size;         // Tamanho do arquivo de entrada (modo incremental)
+    int64_t mtime_ns;     // Data de modificação da entrada em nanossegundos
+    uint64_t hash;        // Hash do conteúdo, quando calculado
+} ImagePath;
+
+/*
+ * Fila de imagens thread-safe com sincronização de processamento entre múltiplas threads
+ *
+ * As imagens ficam em um buffer circular de `capacity` posições. No modo em
+ * lote o buffer comporta todas as imagens do diretório; nos modos contínuos
+ * (ex.: --watch) ele limita quantas imagens podem aguardar processamento.
+ * Os contadores `size`, `current`, `processed` e `failed` só crescem.
+ * Diretórios e nomes das imagens ficam em `table`, protegida pelo mutex.
+ *
+ * Utiliza as seguintes estratégias:
+ * 1. mutex - Garante exclusão mútua ao acessar a fila
+ * 2. queue_cond - Variável de condição para sinalizar quando há/não há trabalho
+ * 3. done_cond - Variável de condição para indicar conclusão do processamento
+ * 4. space_cond - Variável de condição para o produtor esperar por espaço livre
+ * 5. parked_cond - Variável de condição das trabalhadoras acima do limite de threads ativas
+ */
+typedef struct
+{
+    ImagePath *paths;   // Buffer com as imagens
+    PathTable table;    // Diretórios e nomes referenciados pelas imagens
+    int capacity;       // Número de posições do buffer
+    int size;           // Número de imagens inseridas
+    int duplicates;     // Cópias idênticas guardadas após paths[size - 1]
+    int current;        // Índice da próxima imagem a ser processada
+    int processed;      // Contador de imagens já processadas
+    int failed;         // Contador de imagens que falharam
+    int should_exit;    // Flag para indicar que as threads devem terminar
+    int active_limit;   // Trabalhadoras com id >= limite ficam suspensas
+    size_t names_tail;  // Fim dos nomes já copiados pelas trabalhadoras (modos contínuos)
+    int64_t pixels;     // Total de pixels das imagens processadas
+    double total_time;  // Tempo total acumulado em segundos
+
+    pthread_mutex_t mutex;
+    // Define a espera das Threads trabalhadoras por imagens
+    pthread_cond_t queue_cond;
+    // Define a espera da Thread principal pela conclusão do processamento
+    pthread_cond_t done_cond;
+    // Define a espera do produtor quando a fila limitada está cheia
+    pthread_cond_t space_cond;
+    // Define a espera das Threads trabalhadoras suspensas pelo limite de threads ativas
+    pthread_cond_t parked_cond;
+} Queue;
+
+void queue_init(Queue *queue);
+void queue_destroy(Queue *queue);
+void queue_load(Queue *queue, ImagePath *paths, int count, int duplicates, PathTable *table);
+int queue_reset_stream(Queue *queue, int capacity);
+
+int queue_push(Queue *queue, const char *input_path, const char *output_path);
+int get_next_image(Queue *queue, int worker_id, ImagePath *path,
+                   char *input_path, char *output_path, size_t size);
+void complete_image(Queue *queue, int index, int success, int64_t pixels);
+void queue_set_active_limit(Queue *queue, int limit);
+void queue_wait_done(Queue *queue);
+void queue_shutdown(Queue *queue);
+
+int image_paths(const PathTable *table, const ImagePath *path,
+                char *input_path, char *output_path, size_t size);
+
+#endif
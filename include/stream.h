@@ -0,0 +1,26 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdio.h>
+#include "options.h"
+#include "ui.h"
+
+/*
+ * Origem e destino das imagens do modo fluxo
+ *
+ * A origem é um fluxo enquadrado (stdin ou arquivo tar) ou, sem `in`, um
+ * diretório; o destino é um fluxo enquadrado ou, sem `out`, um diretório
+ */
+typedef struct
+{
+    FILE *in;
+    StreamFormat in_format;
+    const char *input_dir;
+    FILE *out;
+    StreamFormat out_format;
+    const char *output_dir;
+} StreamEnds;
+
+int run_stream(const StreamEnds *ends, const Options *opts, RunSummary *summary);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef TAR_H
+#define TAR_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Tamanho de um bloco tar (cabeçalhos e dados são múltiplos dele)
+#define TAR_BLOCK_SIZE 512
+
+/*
+ * Membro de um arquivo tar lido sequencialmente
+ */
+typedef struct
+{
+    char *name;     // Caminho dentro do arquivo (alocado; liberar com free)
+    uint64_t size;  // Tamanho dos dados
+    int64_t mtime;  // Data de modificação (segundos)
+    int mode;       // Permissões
+} TarMember;
+
+int tar_next_member(FILE *file, TarMember *member);
+unsigned char *tar_read_data(FILE *file, const TarMember *member);
+int tar_write_member(FILE *file, const char *name, const void *data, uint64_t size, int64_t mtime,
+                     int mode);
+int tar_write_end(FILE *file);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdint.h>
+
+/*
+ * Etapas medidas no processamento de cada imagem
+ */
+typedef enum
+{
+    STAGE_QUEUE_WAIT, // Espera da trabalhadora até receber a imagem
+    STAGE_READ,       // Leitura do arquivo de entrada
+    STAGE_DECODE,     // Decodificação para RGB
+    STAGE_TRANSFORM,  // Aplicação dos filtros
+    STAGE_ENCODE,     // Codificação JPEG
+    STAGE_WRITE,      // Gravação da saída
+    STAGE_COUNT,
+} Stage;
+
+/*
+ * Resumo de uma etapa, somando todas as threads
+ */
+typedef struct
+{
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t p50_ns;
+    uint64_t p90_ns;
+    uint64_t p99_ns;
+    uint64_t max_ns;
+    int64_t pixels;   // Pixels das imagens medidas (0 nas esperas)
+} StageStats;
+
+void timing_enable(void);
+uint64_t timing_now(void);
+void timing_record(Stage stage, uint64_t start, uint64_t end, int64_t pixels);
+void timing_collect(StageStats stats[STAGE_COUNT]);
+const char *stage_name(Stage stage);
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+void trace_enable(void);
+int trace_enabled(void);
+void trace_set_thread(const char *role, int id);
+void trace_span(const char *category, const char *name, uint64_t start, uint64_t end,
+                const char *text_key, const char *text, const char *number_key, int64_t number);
+int trace_write(const char *path);
+
+#endif
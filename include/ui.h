@@ -1,11 +1,53 @@
 #ifndef UI_H
 #define UI_H
 
+#include <stdio.h>
+#include <stdint.h>
+#include "timing.h"
+#include "lock_stats.h"
+#include "perf_counters.h"
+
+/*
+ * Resumo de uma execução, exibido ao final
+ */
+typedef struct
+{
+    int status;      // Código de saída do programa
+    int processed;   // Imagens processadas (inclui duplicatas ligadas)
+    int failed;      // Imagens que falharam
+    int skipped;     // Imagens já atualizadas (modo incremental)
+    int duplicates;  // Duplicatas ligadas à saída da original
+    int64_t pixels;  // Pixels decodificados
+    double elapsed;  // Tempo total de processamento em segundos
+    int threads;
+    int io_threads;
+} RunSummary;
+
+void set_report_stream(FILE *stream);
+
 char *get_input_directory();
-int get_thread_count();
+int get_thread_count(int default_threads);
 char *get_edit_type();
 
 void display_processing_result(const char *edit_type, int count, double elapsed);
-void display_final_statistics(int total_processed, double total_time, int num_threads);
+void display_job_result(const char *input_dir, const char *filter, const char *output_dir,
+                        int processed, int failed, int skipped, int error);
+void display_skipped_images(int count);
+void display_duplicates(int linked, int duplicates);
+void display_affinity(const int *cpus, int num_threads);
+void display_controller_summary(int active, int peak, int max_threads, int adjustments);
+void display_io_pool(int io_threads, int queues, int peak_waiting);
+void display_cpu_limit_change(int cpus);
+void display_watching(const char *input_dir);
+void display_daemon_listening(const char *socket_path);
+void display_unpacked(int extracted, int failed, const char *output_dir);
+void display_final_statistics(const RunSummary *summary);
+void display_summary_json(FILE *stream, const RunSummary *summary);
+void display_stage_timings(const StageStats *stats);
+void display_stage_timings_json(const StageStats *stats);
+void display_lock_stats(const LockStats *stats, int count);
+void display_lock_stats_json(const LockStats *stats, int count);
+void display_stage_counters(const StageCounters *stats, int available);
+void display_stage_counters_json(const StageCounters *stats, int available);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,9 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+#include "queue.h"
+
+int watch_directory(Queue *queue, const char *input_dir, const char *output_dir,
+                    int queue_size, int debounce_ms);
+
+#endif
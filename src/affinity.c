@@ -0,0 +1,303 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "affinity.h"
+#include "cgroup.h"
+
+#define MAX_NUMA_NODES 1024
+
+/*
+ * CPU permitida ao processo e o nó NUMA a que pertence
+ */
+typedef struct
+{
+    int cpu;
+    int node;
+} CpuSlot;
+
+/**
+ * @brief Interpreta uma lista de CPUs no formato do kernel ("0-3,8,10-11")
+ *
+ * @return Quantidade de CPUs na lista, ou -1 se o formato for inválido
+ */
+int parse_cpu_list(const char *text, cpu_set_t *set)
+{
+    CPU_ZERO(set);
+    const char *p = text;
+    while (*p && *p != '\n')
+    {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p || first < 0 || first >= CPU_SETSIZE)
+            return -1;
+        long last = first;
+        p = end;
+        if (*p == '-')
+        {
+            last = strtol(p + 1, &end, 10);
+            if (end == p + 1 || last < first || last >= CPU_SETSIZE)
+                return -1;
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; cpu++)
+            CPU_SET(cpu, set);
+        if (*p == ',')
+            p++;
+        else if (*p && *p != '\n')
+            return -1;
+    }
+    return CPU_COUNT(set);
+}
+
+/*
+ * CPUs em que o processo pode executar: máscara de afinidade limitada pelo
+ * cpuset do cgroup
+ */
+int allowed_cpus(void)
+{
+    cpu_set_t allowed;
+    int count = 1;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0 && CPU_COUNT(&allowed) > 0)
+        count = CPU_COUNT(&allowed);
+
+    int cpuset = cgroup_cpuset_count();
+    if (cpuset > 0 && cpuset < count)
+        count = cpuset;
+    return count;
+}
+
+/**
+ * @brief Paralelismo padrão: CPUs permitidas limitadas pela cota do cgroup
+ *
+ * Em contêineres, a contagem de CPUs do host ignora a cota (cpu.max); com mais
+ * threads ativas do que a cota, o CFS suspende o processo no fim de cada
+ * período. A cota fracionária é arredondada para baixo (mínimo 1) para não
+ * ultrapassá-la.
+ */
+int available_cpus(void)
+{
+    int count = allowed_cpus();
+    double quota = cgroup_cpu_quota();
+    if (quota > 0)
+    {
+        int quota_cpus = quota < 1 ? 1 : (int)quota;
+        if (quota_cpus < count)
+            count = quota_cpus;
+    }
+    return count;
+}
+
+/*
+ * Lê de /sys o nó NUMA de cada CPU permitida. Sem a informação (kernel sem
+ * NUMA), todas ficam no nó 0.
+ */
+static int read_topology(CpuSlot *slots)
+{
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        return 0;
+
+    int node_of[CPU_SETSIZE];
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        node_of[cpu] = 0;
+
+    char path[64], line[4096];
+    for (int node = 0; node < MAX_NUMA_NODES; node++)
+    {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        FILE *file = fopen(path, "r");
+        if (!file)
+            continue;
+        cpu_set_t node_cpus;
+        if (fgets(line, sizeof(line), file) && parse_cpu_list(line, &node_cpus) > 0)
+        {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+                if (CPU_ISSET(cpu, &node_cpus))
+                    node_of[cpu] = node;
+        }
+        fclose(file);
+    }
+
+    int count = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (CPU_ISSET(cpu, &allowed))
+        {
+            slots[count].cpu = cpu;
+            slots[count].node = node_of[cpu];
+            count++;
+        }
+    }
+    return count;
+}
+
+static int compare_slots(const void *a, const void *b)
+{
+    const CpuSlot *sa = a;
+    const CpuSlot *sb = b;
+    if (sa->node != sb->node)
+        return sa->node - sb->node;
+    return sa->cpu - sb->cpu;
+}
+
+/**
+ * @brief Define em qual CPU cada thread trabalhadora será fixada
+ *
+ * Modos:
+ * - "compact": preenche um nó NUMA antes de passar ao próximo, mantendo as
+ *   threads próximas (menos tráfego entre sockets)
+ * - "scatter": alterna entre os nós, distribuindo banda de memória
+ * - lista de CPUs ("0-7,16-23"): as threads usam as CPUs da lista em ordem,
+ *   ignorando as que não estão na máscara de afinidade do processo
+ *
+ * Com mais threads do que CPUs, a distribuição recomeça do início.
+ *
+ * @param spec Modo ou lista de CPUs
+ * @param num_threads Número de threads trabalhadoras
+ * @param cpus Recebe a CPU de cada thread
+ * @return 1 se sucesso, 0 se o modo é inválido ou nenhuma CPU dele é permitida
+ */
+int affinity_plan(const char *spec, int num_threads, int *cpus)
+{
+    CpuSlot *slots = malloc(CPU_SETSIZE * sizeof(CpuSlot));
+    if (!slots)
+        return 0;
+
+    int count = 0;
+    if (strcmp(spec, "compact") == 0 || strcmp(spec, "scatter") == 0)
+    {
+        count = read_topology(slots);
+        qsort(slots, count, sizeof(CpuSlot), compare_slots);
+    }
+    else if (isdigit((unsigned char)spec[0]))
+    {
+        // Só as CPUs da lista em que o processo pode executar: as demais fariam a criação da thread falhar
+        cpu_set_t listed, allowed;
+        if (parse_cpu_list(spec, &listed) > 0 && sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+        {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+                if (CPU_ISSET(cpu, &listed) && CPU_ISSET(cpu, &allowed))
+                    slots[count++].cpu = cpu;
+        }
+    }
+
+    if (count == 0)
+    {
+        free(slots);
+        return 0;
+    }
+
+    if (strcmp(spec, "scatter") == 0)
+    {
+        // Reordena round-robin entre nós: nó 0, nó 1, ..., nó 0, nó 1, ...
+        CpuSlot *ordered = malloc(count * sizeof(CpuSlot));
+        int *taken = calloc(count, sizeof(int));
+        if (!ordered || !taken)
+        {
+            free(ordered);
+            free(taken);
+            free(slots);
+            return 0;
+        }
+        int placed = 0;
+        while (placed < count)
+        {
+            int last_node = -1;
+            for (int i = 0; i < count; i++)
+            {
+                if (!taken[i] && slots[i].node != last_node)
+                {
+                    ordered[placed++] = slots[i];
+                    taken[i] = 1;
+                    last_node = slots[i].node;
+                }
+            }
+        }
+        memcpy(slots, ordered, count * sizeof(CpuSlot));
+        free(ordered);
+        free(taken);
+    }
+
+    for (int i = 0; i < num_threads; i++)
+        cpus[i] = slots[i % count].cpu;
+
+    free(slots);
+    return 1;
+}
+
+/**
+ * @brief CPUs permitidas do mesmo nó NUMA de `cpu`
+ *
+ * As threads de I/O passam o tempo bloqueadas e não são fixadas em uma CPU,
+ * mas ficam no nó das threads de processamento: os buffers que leem são
+ * alocados no nó de quem os toca primeiro e decodificados lá.
+ *
+ * @param cpu CPU de referência
+ * @param set Recebe as CPUs do nó
+ * @return Quantidade de CPUs em `set`, ou 0 se `cpu` não é permitida
+ */
+int affinity_node_cpus(int cpu, cpu_set_t *set)
+{
+    CPU_ZERO(set);
+    CpuSlot *slots = malloc(CPU_SETSIZE * sizeof(CpuSlot));
+    if (!slots)
+        return 0;
+
+    int count = read_topology(slots);
+    int node = -1;
+    for (int i = 0; i < count; i++)
+        if (slots[i].cpu == cpu)
+            node = slots[i].node;
+    for (int i = 0; i < count && node >= 0; i++)
+        if (slots[i].node == node)
+            CPU_SET(slots[i].cpu, set);
+
+    free(slots);
+    return CPU_COUNT(set);
+}
+
+/**
+ * @brief Agrupa as threads de um plano de afinidade pelo nó NUMA de suas CPUs
+ *
+ * Os grupos são numerados 0, 1, ... na ordem em que os nós aparecem no plano;
+ * com --io-threads, cada grupo tem a sua fila de passagem.
+ *
+ * @param cpus CPU de cada thread (affinity_plan)
+ * @param num_threads Número de threads
+ * @param groups Recebe o grupo de cada thread
+ * @return Quantidade de grupos (nós distintos), ou 0 se falha de memória
+ */
+int affinity_node_groups(const int *cpus, int num_threads, int *groups)
+{
+    CpuSlot *slots = malloc(CPU_SETSIZE * sizeof(CpuSlot));
+    int *group_nodes = malloc(num_threads * sizeof(int));
+    if (!slots || !group_nodes)
+    {
+        free(slots);
+        free(group_nodes);
+        return 0;
+    }
+
+    int count = read_topology(slots);
+    int group_count = 0;
+    for (int i = 0; i < num_threads; i++)
+    {
+        int node = 0;
+        for (int s = 0; s < count; s++)
+            if (slots[s].cpu == cpus[i])
+                node = slots[s].node;
+
+        int group = 0;
+        while (group < group_count && group_nodes[group] != node)
+            group++;
+        if (group == group_count)
+            group_nodes[group_count++] = node;
+        groups[i] = group;
+    }
+
+    free(slots);
+    free(group_nodes);
+    return group_count;
+}
@@ -0,0 +1,331 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include "buffer_pool.h"
+
+// Menor classe reaproveitada: 64 KB (abaixo disso o malloc já é barato)
+#define MIN_CLASS 16
+// A partir de 2 MB os blocos são mapeados alinhados para usar páginas enormes
+#define HUGE_CLASS 21
+#define HUGE_PAGE_SIZE ((size_t)1 << HUGE_CLASS)
+// Maior classe reaproveitada: 1 GB
+#define MAX_CLASS 30
+// Buffers guardados por classe em cada thread
+#define CACHED_PER_CLASS 2
+// Blocos de páginas enormes guardados por thread, um por tamanho
+#define CACHED_HUGE_BLOCKS 8
+// Limite de bytes guardados somando os pools de todas as threads
+#define MAX_CACHED_BYTES ((size_t)512 * 1024 * 1024)
+
+// Classe dos buffers que não passam pelo pool
+#define NO_CLASS 0
+
+/*
+ * Cabeçalho no início de cada bloco, antes dos dados entregues ao stb.
+ * Ocupa 16 bytes para que os dados mantenham o alinhamento do malloc; cada
+ * classe tem 2^classe bytes ao todo, incluindo o cabeçalho. Os blocos de
+ * páginas enormes (classe HUGE_CLASS) têm um múltiplo de 2 MB ao todo.
+ */
+typedef struct
+{
+    uint32_t size_class;
+    uint32_t mapped;  // Bloco obtido com mmap (liberado com munmap)
+    size_t capacity;  // Bytes utilizáveis após o cabeçalho
+} BlockHeader;
+
+// Buffer livre guardado no pool (o encadeamento usa a própria memória)
+typedef struct FreeBlock
+{
+    struct FreeBlock *next;
+} FreeBlock;
+
+/*
+ * Buffers livres de uma thread, por classe de tamanho; os blocos de páginas
+ * enormes ficam à parte, identificados pelo tamanho exato
+ */
+typedef struct
+{
+    FreeBlock *free[HUGE_CLASS];
+    int count[HUGE_CLASS];
+    BlockHeader *huge[CACHED_HUGE_BLOCKS]; // Do mais antigo ao mais recente
+    int huge_count;
+    int registered;
+} BufferPool;
+
+static __thread BufferPool thread_pool;
+// Bytes guardados em todos os pools (acesso atômico)
+static size_t cached_bytes;
+static pthread_key_t pool_key;
+static pthread_once_t pool_key_once = PTHREAD_ONCE_INIT;
+
+static void *header_to_data(BlockHeader *header)
+{
+    return header + 1;
+}
+
+static BlockHeader *data_to_header(void *ptr)
+{
+    return (BlockHeader *)ptr - 1;
+}
+
+/*
+ * PÁGINAS ENORMES
+ *
+ * Um buffer de dezenas de MB em páginas de 4 KB custa milhares de faltas de
+ * página e ocupa muitas entradas da TLB. Os blocos grandes são mapeados
+ * alinhados a 2 MB: primeiro do pool reservado do kernel (MAP_HUGETLB, quando
+ * o administrador reservou páginas em /proc/sys/vm/nr_hugepages); senão, com
+ * MADV_HUGEPAGE, que pede ao kernel páginas enormes transparentes mesmo no
+ * modo "madvise". O tamanho é arredondado para um múltiplo de 2 MB, e não
+ * para uma potência de 2, para não desperdiçar até metade das páginas
+ * enormes reservadas.
+ */
+static BlockHeader *map_huge_block(size_t size)
+{
+    void *block = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (block != MAP_FAILED)
+        return block;
+
+    // Mapeia com folga e recorta as pontas para alinhar o início a 2 MB
+    size_t length = size + HUGE_PAGE_SIZE;
+    char *region = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED)
+        return NULL;
+
+    char *aligned = (char *)(((uintptr_t)region + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+    if (aligned > region)
+        munmap(region, (size_t)(aligned - region));
+    size_t tail = (size_t)(region + length - (aligned + size));
+    if (tail > 0)
+        munmap(aligned + size, tail);
+
+    madvise(aligned, size, MADV_HUGEPAGE);
+    return (BlockHeader *)aligned;
+}
+
+// Tamanho do bloco de páginas enormes que comporta `size` bytes além do cabeçalho
+static size_t huge_block_size(size_t size)
+{
+    return (size + sizeof(BlockHeader) + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+}
+
+// Aloca um bloco novo de `size` bytes ao todo, da classe `c`
+static BlockHeader *alloc_block(int c, size_t size)
+{
+    BlockHeader *header = c >= HUGE_CLASS ? map_huge_block(size) : malloc(size);
+    if (!header)
+        return NULL;
+    header->size_class = (uint32_t)c;
+    header->mapped = c >= HUGE_CLASS;
+    header->capacity = size - sizeof(BlockHeader);
+    return header;
+}
+
+static void free_block(BlockHeader *header)
+{
+    if (header->mapped)
+        munmap(header, header->capacity + sizeof(BlockHeader));
+    else
+        free(header);
+}
+
+/*
+ * LIMITE GLOBAL
+ *
+ * O limite de bytes guardados vale para o processo: com um limite por
+ * thread, dezenas de threads guardando buffers de imagens grandes reteriam
+ * dezenas de GB. Cada buffer guardado reserva o seu tamanho do total antes
+ * de entrar no pool da thread e o devolve ao sair.
+ */
+static int reserve_cached(size_t size)
+{
+    size_t cached = __atomic_load_n(&cached_bytes, __ATOMIC_RELAXED);
+    do
+    {
+        if (cached + size > MAX_CACHED_BYTES)
+            return 0;
+    } while (!__atomic_compare_exchange_n(&cached_bytes, &cached, cached + size, 1, __ATOMIC_RELAXED,
+                                          __ATOMIC_RELAXED));
+    return 1;
+}
+
+static void release_cached(size_t size)
+{
+    __atomic_sub_fetch(&cached_bytes, size, __ATOMIC_RELAXED);
+}
+
+// Devolve ao sistema os buffers guardados quando a thread termina
+static void release_pool(void *arg)
+{
+    BufferPool *pool = arg;
+    for (int c = MIN_CLASS; c < HUGE_CLASS; c++)
+    {
+        while (pool->free[c])
+        {
+            FreeBlock *block = pool->free[c];
+            pool->free[c] = block->next;
+            free_block(data_to_header(block));
+            release_cached((size_t)1 << c);
+        }
+        pool->count[c] = 0;
+    }
+    for (int i = 0; i < pool->huge_count; i++)
+    {
+        release_cached(pool->huge[i]->capacity + sizeof(BlockHeader));
+        free_block(pool->huge[i]);
+    }
+    pool->huge_count = 0;
+}
+
+static void create_pool_key(void)
+{
+    pthread_key_create(&pool_key, release_pool);
+}
+
+static BufferPool *current_pool(void)
+{
+    BufferPool *pool = &thread_pool;
+    if (!pool->registered)
+    {
+        pthread_once(&pool_key_once, create_pool_key);
+        pthread_setspecific(pool_key, pool);
+        pool->registered = 1;
+    }
+    return pool;
+}
+
+// Menor classe cujo bloco comporta `size` bytes além do cabeçalho
+static int size_class(size_t size)
+{
+    int c = MIN_CLASS;
+    while (c <= MAX_CLASS && ((size_t)1 << c) - sizeof(BlockHeader) < size)
+        c++;
+    return c;
+}
+
+void *pool_malloc(size_t size)
+{
+    int c = size_class(size);
+    if (size < ((size_t)1 << MIN_CLASS) || c > MAX_CLASS)
+    {
+        // Fora das classes: alocação direta, sem arredondar
+        BlockHeader *header = malloc(sizeof(BlockHeader) + size);
+        if (!header)
+            return NULL;
+        header->size_class = NO_CLASS;
+        header->mapped = 0;
+        header->capacity = size;
+        return header_to_data(header);
+    }
+
+    BufferPool *pool = current_pool();
+    if (c >= HUGE_CLASS)
+    {
+        // Reaproveita só um bloco guardado de exatamente o mesmo tamanho
+        size_t block_size = huge_block_size(size);
+        for (int i = 0; i < pool->huge_count; i++)
+        {
+            BlockHeader *header = pool->huge[i];
+            if (header->capacity + sizeof(BlockHeader) == block_size)
+            {
+                memmove(&pool->huge[i], &pool->huge[i + 1], (pool->huge_count - i - 1) * sizeof(BlockHeader *));
+                pool->huge_count--;
+                release_cached(block_size);
+                return header_to_data(header);
+            }
+        }
+        BlockHeader *header = alloc_block(HUGE_CLASS, block_size);
+        return header ? header_to_data(header) : NULL;
+    }
+
+    if (pool->free[c])
+    {
+        FreeBlock *block = pool->free[c];
+        pool->free[c] = block->next;
+        pool->count[c]--;
+        release_cached((size_t)1 << c);
+        return block;
+    }
+
+    BlockHeader *header = alloc_block(c, (size_t)1 << c);
+    return header ? header_to_data(header) : NULL;
+}
+
+/*
+ * Guarda um bloco de páginas enormes no pool da thread: no máximo um por
+ * tamanho, e com a tabela cheia o mais antigo dá lugar ao novo
+ */
+static void huge_free(BufferPool *pool, BlockHeader *header)
+{
+    size_t block_size = header->capacity + sizeof(BlockHeader);
+    for (int i = 0; i < pool->huge_count; i++)
+    {
+        if (pool->huge[i]->capacity + sizeof(BlockHeader) == block_size)
+        {
+            free_block(header);
+            return;
+        }
+    }
+
+    if (pool->huge_count == CACHED_HUGE_BLOCKS)
+    {
+        BlockHeader *oldest = pool->huge[0];
+        memmove(&pool->huge[0], &pool->huge[1], (CACHED_HUGE_BLOCKS - 1) * sizeof(BlockHeader *));
+        pool->huge_count--;
+        release_cached(oldest->capacity + sizeof(BlockHeader));
+        free_block(oldest);
+    }
+
+    if (!reserve_cached(block_size))
+    {
+        free_block(header);
+        return;
+    }
+    pool->huge[pool->huge_count++] = header;
+}
+
+void pool_free(void *ptr)
+{
+    if (!ptr)
+        return;
+
+    BlockHeader *header = data_to_header(ptr);
+    int c = (int)header->size_class;
+    BufferPool *pool = c != NO_CLASS ? current_pool() : NULL;
+    if (pool && c >= HUGE_CLASS)
+    {
+        huge_free(pool, header);
+        return;
+    }
+    if (!pool || pool->count[c] >= CACHED_PER_CLASS || !reserve_cached((size_t)1 << c))
+    {
+        free_block(header);
+        return;
+    }
+
+    FreeBlock *block = ptr;
+    block->next = pool->free[c];
+    pool->free[c] = block;
+    pool->count[c]++;
+}
+
+void *pool_realloc(void *ptr, size_t old_size, size_t new_size)
+{
+    if (!ptr)
+        return pool_malloc(new_size);
+
+    BlockHeader *header = data_to_header(ptr);
+    if (new_size <= header->capacity)
+        return ptr;
+
+    void *grown = pool_malloc(new_size);
+    if (!grown)
+        return NULL;
+    memcpy(grown, ptr, old_size < header->capacity ? old_size : header->capacity);
+    pool_free(ptr);
+    return grown;
+}
@@ -0,0 +1,514 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "bulkedit.h"
+#include "img_editing.h"
+#include "affinity.h"
+
+// Posições de trabalho alocadas inicialmente (o array cresce conforme o uso)
+#define INITIAL_JOB_SLOTS 64
+
+// Sem posição (fim das listas encadeadas por índice)
+#define NO_SLOT -1
+
+typedef enum
+{
+    JOB_FREE,
+    JOB_PENDING,
+    JOB_RUNNING,
+    JOB_DONE,
+} JobState;
+
+/*
+ * Trabalho submetido ao pool
+ *
+ * As posições livres são reaproveitadas; o identificador entregue ao usuário
+ * combina a posição com a geração dela, para que um identificador antigo
+ * não alcance o trabalho seguinte da mesma posição
+ */
+typedef struct
+{
+    uint32_t generation;
+    JobState state;
+    char *input_path;           // Trabalho por caminho (NULL se por buffer)
+    char *output_path;
+    const unsigned char *input; // Trabalho por buffer: pertence ao usuário até a conclusão
+    size_t input_size;
+    Transform transform;
+    BulkEditCallback callback;  // Chamada na conclusão (NULL = consultar com poll/wait)
+    void *context;
+    BulkEditResult result;
+    int next;                   // Próxima posição na fila de pendentes ou na lista livre
+} BulkEditJob;
+
+/*
+ * Pool de threads da biblioteca
+ *
+ * 1. mutex - Exclusão mútua sobre os trabalhos e as listas
+ * 2. job_cond - Threads do pool esperam por trabalhos pendentes
+ * 3. done_cond - Chamadores de bulkedit_wait esperam pela conclusão
+ * 4. parked_cond - Threads acima do limite de threads ativas esperam o limite aumentar
+ */
+struct BulkEditPool
+{
+    BulkEditJob *jobs;
+    int capacity;
+    int free_head;      // Lista de posições livres
+    int pending_head;   // Fila de trabalhos pendentes, em ordem de submissão
+    int pending_tail;
+    int should_exit;
+    int quality;        // Qualidade JPEG das saídas
+    pthread_t *threads;
+    int num_threads;
+    int next_thread;    // Índice da próxima thread a iniciar
+    int active_limit;   // Threads com índice >= limite ficam suspensas
+
+    pthread_mutex_t mutex;
+    pthread_cond_t job_cond;
+    pthread_cond_t done_cond;
+    pthread_cond_t parked_cond;
+};
+
+static int64_t job_id(const BulkEditPool *pool, int slot)
+{
+    return ((int64_t)pool->jobs[slot].generation << 32) | (uint32_t)slot;
+}
+
+// Posição do trabalho, ou NO_SLOT se o identificador não é válido
+static int job_slot(const BulkEditPool *pool, int64_t job)
+{
+    if (job <= 0)
+        return NO_SLOT;
+    int slot = (int)(job & 0xFFFFFFFF);
+    if (slot < 0 || slot >= pool->capacity || pool->jobs[slot].state == JOB_FREE ||
+        pool->jobs[slot].generation != (uint32_t)(job >> 32))
+        return NO_SLOT;
+    return slot;
+}
+
+// Encadeia as posições [first, capacity) na lista livre
+static void link_free_slots(BulkEditPool *pool, int first)
+{
+    for (int i = pool->capacity - 1; i >= first; i--)
+    {
+        memset(&pool->jobs[i], 0, sizeof(BulkEditJob));
+        pool->jobs[i].next = pool->free_head;
+        pool->free_head = i;
+    }
+}
+
+static void release_slot(BulkEditPool *pool, int slot)
+{
+    BulkEditJob *job = &pool->jobs[slot];
+    free(job->input_path);
+    free(job->output_path);
+    job->input_path = NULL;
+    job->output_path = NULL;
+    job->input = NULL;
+    job->state = JOB_FREE;
+    job->next = pool->free_head;
+    pool->free_head = slot;
+}
+
+static void *pool_worker(void *arg)
+{
+    BulkEditPool *pool = arg;
+
+    pthread_mutex_lock(&pool->mutex);
+    int index = pool->next_thread++;
+    while (1)
+    {
+        /*
+         * SUSPENSÃO CONTROLADA - job_cond
+         *
+         * Sem trabalhos pendentes, a thread dorme até uma submissão. Acima do
+         * limite de threads ativas, dorme em parked_cond, para que o sinal de
+         * uma submissão sempre acorde uma thread que possa atendê-la
+         */
+        while ((pool->pending_head == NO_SLOT || index >= pool->active_limit) && !pool->should_exit)
+        {
+            if (index >= pool->active_limit)
+                pthread_cond_wait(&pool->parked_cond, &pool->mutex);
+            else
+                pthread_cond_wait(&pool->job_cond, &pool->mutex);
+        }
+        if (pool->should_exit)
+            break;
+
+        int slot = pool->pending_head;
+        BulkEditJob job = pool->jobs[slot];
+        pool->pending_head = job.next;
+        if (pool->pending_head == NO_SLOT)
+            pool->pending_tail = NO_SLOT;
+        pool->jobs[slot].state = JOB_RUNNING;
+        pthread_mutex_unlock(&pool->mutex);
+
+        // Processa fora do mutex (o array de trabalhos pode crescer enquanto isso)
+        BulkEditResult result = {0};
+        if (job.input_path)
+            result.success = transform_image(job.input_path, job.output_path, &job.transform, &result.pixels);
+        else
+            result.success = transform_buffer(job.input, job.input_size, &job.transform, &result.output,
+                                              &result.output_size, NULL, NULL, &result.pixels);
+
+        pthread_mutex_lock(&pool->mutex);
+        if (job.callback)
+        {
+            // Com callback o resultado é entregue direto, e a posição já é liberada
+            int64_t id = job_id(pool, slot);
+            release_slot(pool, slot);
+            pthread_mutex_unlock(&pool->mutex);
+            job.callback(id, &result, job.context);
+            pthread_mutex_lock(&pool->mutex);
+            continue;
+        }
+        pool->jobs[slot].result = result;
+        pool->jobs[slot].state = JOB_DONE;
+
+        // SUSPENSÃO CONTROLADA - done_cond: acorda quem espera por trabalhos
+        pthread_cond_broadcast(&pool->done_cond);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+/**
+ * @brief Cria um pool de threads para processar trabalhos
+ *
+ * Com num_threads 0, é criada uma thread por CPU permitida (afinidade e
+ * cpuset), mas só uma por CPU disponível segundo a cota do cgroup começa
+ * ativa; bulkedit_pool_set_active ajusta esse limite depois.
+ *
+ * @param num_threads Número de threads (0 = uma por CPU disponível)
+ * @return Pool, ou NULL se falha
+ */
+BulkEditPool *bulkedit_pool_create(int num_threads)
+{
+    if (num_threads < 0)
+        return NULL;
+    int active = num_threads;
+    if (num_threads == 0)
+    {
+        num_threads = allowed_cpus();
+        active = available_cpus();
+    }
+
+    BulkEditPool *pool = calloc(1, sizeof(BulkEditPool));
+    if (!pool)
+        return NULL;
+    pool->capacity = INITIAL_JOB_SLOTS;
+    pool->jobs = malloc(pool->capacity * sizeof(BulkEditJob));
+    pool->threads = malloc(num_threads * sizeof(pthread_t));
+    if (!pool->jobs || !pool->threads)
+    {
+        free(pool->jobs);
+        free(pool->threads);
+        free(pool);
+        return NULL;
+    }
+    pool->quality = DEFAULT_QUALITY;
+    pool->active_limit = active;
+    pool->free_head = NO_SLOT;
+    pool->pending_head = NO_SLOT;
+    pool->pending_tail = NO_SLOT;
+    link_free_slots(pool, 0);
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->job_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+    pthread_cond_init(&pool->parked_cond, NULL);
+
+    for (int i = 0; i < num_threads; i++)
+    {
+        if (pthread_create(&pool->threads[i], NULL, pool_worker, pool) != 0)
+            break;
+        pool->num_threads++;
+    }
+    if (pool->num_threads == 0)
+    {
+        bulkedit_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+/**
+ * @brief Encerra o pool
+ *
+ * Aguarda os trabalhos em execução; os pendentes são descartados e os
+ * resultados não consultados são liberados
+ */
+void bulkedit_pool_destroy(BulkEditPool *pool)
+{
+    if (!pool)
+        return;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->should_exit = 1;
+    pthread_cond_broadcast(&pool->job_cond);
+    pthread_cond_broadcast(&pool->parked_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < pool->num_threads; i++)
+    {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    for (int i = 0; i < pool->capacity; i++)
+    {
+        free(pool->jobs[i].input_path);
+        free(pool->jobs[i].output_path);
+        free(pool->jobs[i].result.output);
+    }
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->job_cond);
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->parked_cond);
+    free(pool->jobs);
+    free(pool->threads);
+    free(pool);
+}
+
+/**
+ * @brief Define a qualidade JPEG dos trabalhos submetidos a seguir (padrão 100)
+ *
+ * Deve ser chamada antes das submissões, não concorrentemente a elas
+ *
+ * @return 1 se sucesso, 0 se a qualidade está fora de 1-100
+ */
+int bulkedit_pool_set_quality(BulkEditPool *pool, int quality)
+{
+    if (quality < 1 || quality > 100)
+        return 0;
+    pool->quality = quality;
+    return 1;
+}
+
+/**
+ * @brief Limita quantas threads do pool processam trabalhos
+ *
+ * As threads acima do limite terminam o trabalho atual e ficam suspensas até
+ * o limite aumentar. Permite acompanhar mudanças na cota de CPU do cgroup
+ * sem recriar o pool.
+ *
+ * @param active Threads ativas desejadas (ajustado a 1..threads criadas)
+ * @return Threads ativas após o ajuste
+ */
+int bulkedit_pool_set_active(BulkEditPool *pool, int active)
+{
+    pthread_mutex_lock(&pool->mutex);
+    if (active < 1)
+        active = 1;
+    if (active > pool->num_threads)
+        active = pool->num_threads;
+    if (active > pool->active_limit)
+        pthread_cond_broadcast(&pool->parked_cond);
+    else if (active < pool->active_limit)
+        pthread_cond_broadcast(&pool->job_cond);
+    pool->active_limit = active;
+    pthread_mutex_unlock(&pool->mutex);
+    return active;
+}
+
+// Coloca um trabalho preenchido na fila de pendentes; chamada com o mutex travado
+static int64_t enqueue_job(BulkEditPool *pool, const BulkEditJob *filled)
+{
+    if (pool->free_head == NO_SLOT)
+    {
+        BulkEditJob *grown = realloc(pool->jobs, 2 * pool->capacity * sizeof(BulkEditJob));
+        if (!grown)
+            return -1;
+        pool->jobs = grown;
+        int first = pool->capacity;
+        pool->capacity *= 2;
+        link_free_slots(pool, first);
+    }
+
+    int slot = pool->free_head;
+    BulkEditJob *job = &pool->jobs[slot];
+    pool->free_head = job->next;
+
+    uint32_t generation = job->generation + 1;
+    *job = *filled;
+    job->generation = generation ? generation : 1;
+    job->state = JOB_PENDING;
+    job->next = NO_SLOT;
+
+    if (pool->pending_tail != NO_SLOT)
+        pool->jobs[pool->pending_tail].next = slot;
+    else
+        pool->pending_head = slot;
+    pool->pending_tail = slot;
+
+    // SUSPENSÃO CONTROLADA - job_cond: acorda uma thread do pool
+    pthread_cond_signal(&pool->job_cond);
+    return job_id(pool, slot);
+}
+
+/**
+ * @brief Submete uma imagem em disco; a saída JPEG é gravada em `output_path`
+ *
+ * @return Identificador do trabalho, ou -1 se o filtro não existe ou falta memória
+ */
+int64_t bulkedit_submit_path(BulkEditPool *pool, const char *input_path, const char *output_path,
+                             const char *filter)
+{
+    return bulkedit_submit_path_callback(pool, input_path, output_path, filter, NULL, NULL);
+}
+
+/**
+ * @brief Como bulkedit_submit_path, mas entrega o resultado a `callback`
+ *
+ * A callback é chamada em uma thread do pool assim que o trabalho termina;
+ * o identificador já está liberado e não deve ser consultado com poll/wait.
+ * Trabalhos ainda pendentes ao destruir o pool são descartados sem callback.
+ */
+int64_t bulkedit_submit_path_callback(BulkEditPool *pool, const char *input_path,
+                                      const char *output_path, const char *filter,
+                                      BulkEditCallback callback, void *context)
+{
+    BulkEditJob job = {0};
+    job.callback = callback;
+    job.context = context;
+    if (!parse_transform(filter, pool->quality, &job.transform))
+        return -1;
+    job.input_path = strdup(input_path);
+    job.output_path = strdup(output_path);
+    if (!job.input_path || !job.output_path)
+    {
+        free(job.input_path);
+        free(job.output_path);
+        return -1;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    int64_t id = enqueue_job(pool, &job);
+    pthread_mutex_unlock(&pool->mutex);
+    if (id < 0)
+    {
+        free(job.input_path);
+        free(job.output_path);
+    }
+    return id;
+}
+
+/**
+ * @brief Submete uma imagem codificada em memória (JPG ou PNG)
+ *
+ * O buffer não é copiado: deve permanecer válido até a conclusão do trabalho.
+ * O JPEG gerado é entregue em `result.output`.
+ *
+ * @return Identificador do trabalho, ou -1 se o filtro não existe ou falta memória
+ */
+int64_t bulkedit_submit_buffer(BulkEditPool *pool, const void *input, size_t input_size,
+                               const char *filter)
+{
+    return bulkedit_submit_buffer_callback(pool, input, input_size, filter, NULL, NULL);
+}
+
+/**
+ * @brief Como bulkedit_submit_buffer, mas entrega o resultado a `callback`
+ *
+ * A callback recebe a posse de `result->output` (liberar com bulkedit_free).
+ */
+int64_t bulkedit_submit_buffer_callback(BulkEditPool *pool, const void *input, size_t input_size,
+                                        const char *filter, BulkEditCallback callback, void *context)
+{
+    BulkEditJob job = {0};
+    job.callback = callback;
+    job.context = context;
+    if (!input || !parse_transform(filter, pool->quality, &job.transform))
+        return -1;
+    job.input = input;
+    job.input_size = input_size;
+
+    pthread_mutex_lock(&pool->mutex);
+    int64_t id = enqueue_job(pool, &job);
+    pthread_mutex_unlock(&pool->mutex);
+    return id;
+}
+
+// Entrega o resultado e libera a posição; chamada com o mutex travado
+static void take_result(BulkEditPool *pool, int slot, BulkEditResult *result)
+{
+    if (result)
+        *result = pool->jobs[slot].result;
+    else
+        free(pool->jobs[slot].result.output);
+    memset(&pool->jobs[slot].result, 0, sizeof(BulkEditResult));
+    release_slot(pool, slot);
+}
+
+/**
+ * @brief Consulta um trabalho sem bloquear
+ *
+ * @param result Recebe o resultado se concluído (NULL descarta o resultado)
+ * @return 1 se concluído (identificador liberado), 0 se ainda não, -1 se inválido
+ */
+int bulkedit_poll(BulkEditPool *pool, int64_t job, BulkEditResult *result)
+{
+    pthread_mutex_lock(&pool->mutex);
+    int slot = job_slot(pool, job);
+    int status = slot == NO_SLOT ? -1 : pool->jobs[slot].state == JOB_DONE;
+    if (status == 1)
+        take_result(pool, slot, result);
+    pthread_mutex_unlock(&pool->mutex);
+    return status;
+}
+
+/**
+ * @brief Aguarda a conclusão de um trabalho
+ *
+ * A posição é revalidada (com a geração) a cada despertar: se outra thread
+ * consultou o mesmo identificador enquanto esta dormia, a posição pode já
+ * pertencer a outro trabalho, e o identificador passa a ser desconhecido.
+ *
+ * @param result Recebe o resultado (NULL descarta o resultado)
+ * @return 1 se concluído (identificador liberado), -1 se inválido ou pool encerrado
+ */
+int bulkedit_wait(BulkEditPool *pool, int64_t job, BulkEditResult *result)
+{
+    pthread_mutex_lock(&pool->mutex);
+    int slot = job_slot(pool, job);
+    while (slot != NO_SLOT && pool->jobs[slot].state != JOB_DONE && !pool->should_exit)
+    {
+        pthread_cond_wait(&pool->done_cond, &pool->mutex);
+        slot = job_slot(pool, job);
+    }
+    int status = -1;
+    if (slot != NO_SLOT && pool->jobs[slot].state == JOB_DONE)
+    {
+        take_result(pool, slot, result);
+        status = 1;
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return status;
+}
+
+/**
+ * @brief Transforma uma imagem em memória na thread chamadora, sem pool
+ *
+ * @param input Imagem codificada (JPG ou PNG)
+ * @param input_size Tamanho da imagem codificada
+ * @param filter Nome do filtro, ou filtros separados por vírgula
+ * @param quality Qualidade JPEG da saída (1-100)
+ * @param output Recebe o JPEG gerado (liberar com bulkedit_free)
+ * @param output_size Recebe o tamanho do JPEG
+ * @return 1 se sucesso, 0 se o filtro não existe, a qualidade está fora de
+ *         1-100 ou a imagem é inválida
+ */
+int bulkedit_transform_buffer(const void *input, size_t input_size, const char *filter, int quality,
+                              unsigned char **output, size_t *output_size)
+{
+    Transform transform;
+    int64_t pixels;
+    return input && quality >= 1 && quality <= 100 && parse_transform(filter, quality, &transform) &&
+           transform_buffer(input, input_size, &transform, output, output_size, NULL, NULL, &pixels);
+}
+
+// Libera um buffer entregue pela biblioteca
+void bulkedit_free(void *ptr)
+{
+    free(ptr);
+}
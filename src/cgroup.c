@@ -0,0 +1,194 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "cgroup.h"
+#include "affinity.h"
+
+/*
+ * Caminho do cgroup do processo para um controlador, lido de /proc/self/cgroup
+ *
+ * cgroup v2 tem uma única linha "0::<caminho>"; no v1 cada hierarquia lista
+ * seus controladores ("3:cpu,cpuacct:<caminho>"). `mount` recebe o nome do
+ * diretório da hierarquia em /sys/fs/cgroup ("" para v2).
+ */
+static int find_cgroup(const char *controller, char *mount, size_t mount_size,
+                       char *path, size_t path_size)
+{
+    FILE *file = fopen("/proc/self/cgroup", "r");
+    if (!file)
+        return 0;
+
+    char line[PATH_MAX + 256];
+    int found = 0;
+    while (!found && fgets(line, sizeof(line), file))
+    {
+        line[strcspn(line, "\n")] = 0;
+        char *controllers = strchr(line, ':');
+        if (!controllers)
+            continue;
+        controllers++;
+        char *cgroup_path = strchr(controllers, ':');
+        if (!cgroup_path)
+            continue;
+        *cgroup_path++ = 0;
+
+        if (controller == NULL)
+        {
+            found = controllers[0] == 0;
+        }
+        else
+        {
+            // Procura o controlador na lista separada por vírgulas
+            char list[256];
+            snprintf(list, sizeof(list), "%s", controllers);
+            for (char *save, *token = strtok_r(list, ",", &save); token;
+                 token = strtok_r(NULL, ",", &save))
+            {
+                if (strcmp(token, controller) == 0)
+                    found = 1;
+            }
+        }
+
+        if (found)
+        {
+            snprintf(mount, mount_size, "%s", controllers);
+            snprintf(path, path_size, "%s", cgroup_path);
+        }
+    }
+    fclose(file);
+    return found;
+}
+
+static FILE *open_in_hierarchy(const char *base, const char *path, const char *name)
+{
+    char full[PATH_MAX];
+    snprintf(full, sizeof(full), "%s%s/%s", base, strcmp(path, "/") == 0 ? "" : path, name);
+    return fopen(full, "r");
+}
+
+/*
+ * Lê a cota de um nível da hierarquia. Retorna CPUs (ex.: 2.5), 0 se
+ * ilimitada, ou -1 se o arquivo não existe.
+ */
+static double read_quota(const char *base, const char *path, int v2)
+{
+    if (v2)
+    {
+        FILE *file = open_in_hierarchy(base, path, "cpu.max");
+        if (!file)
+            return -1;
+        char quota[32];
+        long period = 0;
+        int fields = fscanf(file, "%31s %ld", quota, &period);
+        fclose(file);
+        if (fields != 2 || strcmp(quota, "max") == 0 || period <= 0)
+            return 0;
+        return atof(quota) / period;
+    }
+
+    FILE *quota_file = open_in_hierarchy(base, path, "cpu.cfs_quota_us");
+    FILE *period_file = open_in_hierarchy(base, path, "cpu.cfs_period_us");
+    long quota = -1, period = 0;
+    int ok = quota_file && period_file && fscanf(quota_file, "%ld", &quota) == 1 &&
+             fscanf(period_file, "%ld", &period) == 1;
+    if (quota_file)
+        fclose(quota_file);
+    if (period_file)
+        fclose(period_file);
+    if (!ok)
+        return -1;
+    return quota > 0 && period > 0 ? (double)quota / period : 0;
+}
+
+/*
+ * Menor cota entre o cgroup `path` e seus ancestrais em uma hierarquia.
+ * Retorna -1 se nenhum nível tem os arquivos de cota.
+ */
+static double quota_in_hierarchy(const char *base, const char *path, int v2)
+{
+    double limit = 0;
+    int seen = 0;
+    char level[PATH_MAX];
+    snprintf(level, sizeof(level), "%s", path);
+    while (1)
+    {
+        double quota = read_quota(base, level, v2);
+        if (quota >= 0)
+            seen = 1;
+        if (quota > 0 && (limit == 0 || quota < limit))
+            limit = quota;
+
+        char *slash = strrchr(level, '/');
+        if (!slash || strcmp(level, "/") == 0)
+            break;
+        if (slash == level)
+            slash[1] = 0;
+        else
+            *slash = 0;
+    }
+    return seen ? limit : -1;
+}
+
+/**
+ * @brief Cota de CPU imposta ao processo pelo cgroup (cpu.max no v2,
+ * cpu.cfs_quota_us/cpu.cfs_period_us no v1)
+ *
+ * A cota efetiva é a menor entre o cgroup do processo e seus ancestrais.
+ * Dentro de um namespace de cgroup o caminho é "/", e a hierarquia visível
+ * já começa no cgroup do contêiner. Em sistemas híbridos o controlador cpu
+ * pode estar só no v1, então o v1 é consultado quando o v2 não tem cota.
+ *
+ * @return Número de CPUs permitidas (fracionário), ou 0 se não há cota
+ */
+double cgroup_cpu_quota(void)
+{
+    char mount[256], path[PATH_MAX], base[PATH_MAX + 32];
+    double quota = -1;
+
+    if (find_cgroup(NULL, mount, sizeof(mount), path, sizeof(path)))
+    {
+        quota = quota_in_hierarchy("/sys/fs/cgroup", path, 1);
+        if (quota < 0)
+            quota = quota_in_hierarchy("/sys/fs/cgroup/unified", path, 1);
+    }
+    if (quota < 0 && find_cgroup("cpu", mount, sizeof(mount), path, sizeof(path)))
+    {
+        snprintf(base, sizeof(base), "/sys/fs/cgroup/%s", mount);
+        quota = quota_in_hierarchy(base, path, 0);
+        if (quota < 0)
+            quota = quota_in_hierarchy("/sys/fs/cgroup/cpu", path, 0);
+    }
+    return quota > 0 ? quota : 0;
+}
+
+/**
+ * @brief CPUs do cpuset efetivo do cgroup
+ *
+ * Normalmente já refletido na máscara de afinidade, mas a máscara pode ter
+ * sido herdada antes de o processo entrar no cgroup
+ *
+ * @return Quantidade de CPUs, ou 0 se não for possível ler
+ */
+int cgroup_cpuset_count(void)
+{
+    char mount[256], path[PATH_MAX], line[4096];
+    FILE *file = NULL;
+
+    if (find_cgroup(NULL, mount, sizeof(mount), path, sizeof(path)))
+        file = open_in_hierarchy("/sys/fs/cgroup", path, "cpuset.cpus.effective");
+    if (!file && find_cgroup("cpuset", mount, sizeof(mount), path, sizeof(path)))
+    {
+        char base[PATH_MAX + 32];
+        snprintf(base, sizeof(base), "/sys/fs/cgroup/%s", mount);
+        file = open_in_hierarchy(base, path, "cpuset.effective_cpus");
+    }
+    if (!file)
+        return 0;
+
+    cpu_set_t set;
+    int count = fgets(line, sizeof(line), file) ? parse_cpu_list(line, &set) : 0;
+    fclose(file);
+    return count > 0 ? count : 0;
+}
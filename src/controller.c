@@ -0,0 +1,211 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "controller.h"
+#include "affinity.h"
+#include "ui.h"
+#include "lock_stats.h"
+
+// Duração de cada janela de medição
+#define WINDOW_MS 500
+// Variação mínima de vazão considerada real (abaixo disso é ruído)
+#define NOISE_THRESHOLD 0.05
+// Janelas entre releituras da cota de CPU (5 s)
+#define CPU_CHECK_WINDOWS 10
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Espera uma janela ou até controller_stop. Retorna 0 se deve encerrar.
+ */
+static int wait_window(Controller *controller)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += (long)WINDOW_MS * 1000000;
+    deadline.tv_sec += deadline.tv_nsec / 1000000000;
+    deadline.tv_nsec %= 1000000000;
+
+    pthread_mutex_lock(&controller->mutex);
+    while (!controller->stop)
+    {
+        if (pthread_cond_timedwait(&controller->cond, &controller->mutex, &deadline) != 0)
+            break;
+    }
+    int running = !controller->stop;
+    pthread_mutex_unlock(&controller->mutex);
+    return running;
+}
+
+static void set_active(Controller *controller, int active)
+{
+    if (active == controller->active)
+        return;
+    controller->active = active;
+    if (active > controller->peak)
+        controller->peak = active;
+    controller->adjustments++;
+    queue_set_active_limit(controller->queue, active);
+}
+
+/*
+ * Relê as CPUs disponíveis; a cota do cgroup pode mudar com o processo em
+ * execução (ex.: redimensionamento do pod no modo contínuo)
+ */
+static void check_cpu_limit(Controller *controller)
+{
+    int cpus = available_cpus();
+    if (cpus == controller->cpus)
+        return;
+
+    controller->cpus = cpus;
+    controller->ceiling = cpus * controller->threads_per_cpu;
+    if (controller->ceiling > controller->max_threads)
+        controller->ceiling = controller->max_threads;
+
+    int active = controller->hill_climb ? controller->active : controller->ceiling;
+    if (active > controller->ceiling)
+        active = controller->ceiling;
+    if (active != controller->active)
+    {
+        set_active(controller, active);
+        display_cpu_limit_change(active);
+    }
+}
+
+/*
+ * Laço do controlador
+ *
+ * A cada janela compara a vazão com a da janela anterior, sempre na mesma
+ * unidade: megapixels/s quando as duas janelas têm pixels, imagens/s quando
+ * nenhuma tem; se a unidade muda, a janela não é comparada. Se piorou além
+ * do ruído, inverte a direção; caso contrário continua adicionando/removendo
+ * uma thread na mesma direção. Janelas em que a fila esvaziou (fim de lote, espera por arquivos)
+ * não são comparadas, pois a queda de vazão não vem do número de threads.
+ */
+static void *controller_thread(void *arg)
+{
+    Controller *controller = arg;
+    Queue *queue = controller->queue;
+    lock_stats_set_thread("controlador", 0);
+
+    int direction = 1;
+    double previous_rate = -1;
+    int previous_has_pixels = 0; // Unidade de previous_rate: megapixels/s (1) ou imagens/s (0)
+
+    lock_stats_lock(&queue->mutex);
+    int64_t last_pixels = queue->pixels;
+    int last_done = queue->processed + queue->failed;
+    pthread_mutex_unlock(&queue->mutex);
+    double last_time = now_seconds();
+
+    int window = 0;
+    while (wait_window(controller))
+    {
+        if (++window % CPU_CHECK_WINDOWS == 0)
+            check_cpu_limit(controller);
+        if (!controller->hill_climb)
+            continue;
+
+        lock_stats_lock(&queue->mutex);
+        int64_t pixels = queue->pixels;
+        int done = queue->processed + queue->failed;
+        int backlog = queue->size - queue->current;
+        pthread_mutex_unlock(&queue->mutex);
+        double now = now_seconds();
+
+        double elapsed = now - last_time;
+        double pixel_rate = (pixels - last_pixels) / 1e6 / elapsed;
+        double image_rate = (done - last_done) / elapsed;
+        int has_pixels = pixels > last_pixels;
+        int saturated = backlog > 0 && done > last_done;
+
+        last_pixels = pixels;
+        last_done = done;
+        last_time = now;
+
+        if (!saturated)
+        {
+            previous_rate = -1;
+            continue;
+        }
+
+        // Megapixels/s e imagens/s não são comparáveis entre si
+        if (has_pixels != previous_has_pixels)
+            previous_rate = -1;
+        double rate = has_pixels ? pixel_rate : image_rate;
+        if (previous_rate >= 0 && rate < previous_rate * (1 - NOISE_THRESHOLD))
+            direction = -direction;
+        previous_rate = rate;
+        previous_has_pixels = has_pixels;
+
+        int next = controller->active + direction;
+        if (next < 1 || next > controller->ceiling)
+        {
+            direction = -direction;
+            next = controller->active + direction;
+        }
+        if (next < 1 || next > controller->ceiling)
+            continue;
+
+        set_active(controller, next);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Inicia o controlador de concorrência
+ *
+ * Começa com uma thread ativa por CPU disponível.
+ *
+ * @param controller Controlador
+ * @param queue Fila das trabalhadoras
+ * @param max_threads Threads criadas (limite superior)
+ * @param hill_climb 1 para ajustar pela vazão
+ * @param threads_per_cpu Teto de threads ativas por CPU disponível
+ * @return 1 se sucesso, 0 se falha ao criar a thread
+ */
+int controller_start(Controller *controller, Queue *queue, int max_threads, int hill_climb,
+                     int threads_per_cpu)
+{
+    memset(controller, 0, sizeof(*controller));
+    controller->queue = queue;
+    controller->max_threads = max_threads;
+    controller->hill_climb = hill_climb;
+    controller->threads_per_cpu = threads_per_cpu;
+    controller->cpus = available_cpus();
+    controller->ceiling = controller->cpus * threads_per_cpu;
+    if (controller->ceiling > max_threads)
+        controller->ceiling = max_threads;
+    controller->active = controller->cpus < controller->ceiling ? controller->cpus : controller->ceiling;
+    controller->peak = controller->active;
+    pthread_mutex_init(&controller->mutex, NULL);
+    pthread_cond_init(&controller->cond, NULL);
+
+    queue_set_active_limit(queue, controller->active);
+    if (pthread_create(&controller->thread, NULL, controller_thread, controller) != 0)
+    {
+        queue_set_active_limit(queue, max_threads);
+        return 0;
+    }
+    return 1;
+}
+
+void controller_stop(Controller *controller)
+{
+    pthread_mutex_lock(&controller->mutex);
+    controller->stop = 1;
+    pthread_cond_signal(&controller->cond);
+    pthread_mutex_unlock(&controller->mutex);
+
+    pthread_join(controller->thread, NULL);
+    pthread_mutex_destroy(&controller->mutex);
+    pthread_cond_destroy(&controller->cond);
+}
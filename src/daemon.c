@@ -0,0 +1,553 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "daemon.h"
+#include "bulkedit.h"
+#include "affinity.h"
+#include "ui.h"
+
+// Conexões aguardando accept
+#define LISTEN_BACKLOG 64
+// Maior imagem aceita em um pedido por buffer
+#define MAX_INLINE_SIZE ((size_t)256 * 1024 * 1024)
+// Maior identificador de pedido escolhido pelo cliente
+#define MAX_REQUEST_ID 64
+// Pedidos de uma conexão aguardando resposta; acima disso a conexão deixa de ser lida
+#define MAX_IN_FLIGHT 32
+// Intervalo entre releituras da cota de CPU, como no controlador dos lotes
+#define CPU_CHECK_MS 5000
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void handle_stop_signal(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+/*
+ * Pedido submetido ao pool: contexto da callback e, depois, resposta na fila
+ * de escrita da conexão
+ */
+typedef struct Request
+{
+    struct Connection *connection;
+    unsigned char *input;   // Imagem recebida (pedidos por buffer)
+    int inline_output;      // Devolve o JPEG na resposta
+    char id[MAX_REQUEST_ID + 1];
+
+    char header[160];       // Linha da resposta
+    unsigned char *output;  // JPEG devolvido após o cabeçalho (ou NULL)
+    size_t output_size;
+    struct Request *next;
+} Request;
+
+/*
+ * Conexão de um cliente
+ *
+ * Uma thread por conexão lê os pedidos e os submete ao pool. As threads do
+ * pool apenas enfileiram a resposta de cada imagem que termina; uma thread de
+ * escrita por conexão as envia, de modo que um cliente lento não bloqueia o
+ * pool. As respostas podem sair fora da ordem dos pedidos.
+ *
+ * 1. mutex/reply_cond - A thread de escrita espera respostas na fila
+ * 2. mutex/idle_cond - A thread da conexão espera vagas (no máximo
+ *    MAX_IN_FLIGHT pedidos sem resposta) e, no fim, os pedidos em andamento
+ *    antes de fechar o socket
+ */
+typedef struct Connection
+{
+    int fd;
+    BulkEditPool *pool;
+    pthread_t thread;
+    pthread_t writer;
+    int in_flight;      // Pedidos aceitos cuja resposta ainda não foi escrita
+    int closing;        // Sem novos pedidos: a thread de escrita termina ao esvaziar a fila
+    int finished;       // Thread da conexão terminou (pode ser coletada)
+    Request *replies;   // Fila de respostas (primeira)
+    Request *replies_tail;
+    struct Connection *next;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t reply_cond;
+    pthread_cond_t idle_cond;
+} Connection;
+
+static int write_all(int fd, const void *data, size_t size)
+{
+    const char *p = data;
+    while (size > 0)
+    {
+        ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return 0;
+        p += n;
+        size -= (size_t)n;
+    }
+    return 1;
+}
+
+/*
+ * SUSPENSÃO CONTROLADA - idle_cond
+ *
+ * Reserva a vaga de um pedido. Com MAX_IN_FLIGHT respostas pendentes, a
+ * thread da conexão para de ler o socket até a thread de escrita liberar
+ * uma vaga, limitando a memória que um cliente pode ocupar
+ */
+static void reserve_slot(Connection *connection)
+{
+    pthread_mutex_lock(&connection->mutex);
+    while (connection->in_flight >= MAX_IN_FLIGHT)
+    {
+        pthread_cond_wait(&connection->idle_cond, &connection->mutex);
+    }
+    connection->in_flight++;
+    pthread_mutex_unlock(&connection->mutex);
+}
+
+// Libera a vaga de um pedido que não terá resposta
+static void release_slot(Connection *connection)
+{
+    pthread_mutex_lock(&connection->mutex);
+    connection->in_flight--;
+    pthread_cond_signal(&connection->idle_cond);
+    pthread_mutex_unlock(&connection->mutex);
+}
+
+// Entrega uma resposta à thread de escrita (não bloqueia no socket)
+static void queue_reply(Connection *connection, Request *reply)
+{
+    reply->next = NULL;
+    pthread_mutex_lock(&connection->mutex);
+    if (connection->replies_tail)
+        connection->replies_tail->next = reply;
+    else
+        connection->replies = reply;
+    connection->replies_tail = reply;
+    pthread_cond_signal(&connection->reply_cond);
+    pthread_mutex_unlock(&connection->mutex);
+}
+
+// Callback do pool: enfileira a resposta assim que a imagem termina
+static void on_result(int64_t job, const BulkEditResult *result, void *context)
+{
+    (void)job;
+    Request *request = context;
+    if (!result->success)
+        snprintf(request->header, sizeof(request->header), "ERR %s decode-failed\n", request->id);
+    else if (request->inline_output)
+        snprintf(request->header, sizeof(request->header), "OK %s %" PRId64 " %zu\n", request->id,
+                 result->pixels, result->output_size);
+    else
+        snprintf(request->header, sizeof(request->header), "OK %s %" PRId64 "\n", request->id,
+                 result->pixels);
+
+    if (result->success && request->inline_output)
+    {
+        request->output = result->output;
+        request->output_size = result->output_size;
+    }
+    else
+        bulkedit_free(result->output);
+    free(request->input);
+    request->input = NULL;
+    queue_reply(request->connection, request);
+}
+
+/*
+ * Responde com erro um pedido cuja vaga já foi reservada. Sem memória para a
+ * resposta, a vaga é apenas liberada
+ */
+static void send_error(Connection *connection, const char *id, const char *reason)
+{
+    Request *reply = calloc(1, sizeof(Request));
+    if (!reply)
+    {
+        release_slot(connection);
+        return;
+    }
+    reply->connection = connection;
+    snprintf(reply->header, sizeof(reply->header), "ERR %s %s\n", id, reason);
+    queue_reply(connection, reply);
+}
+
+/*
+ * SUSPENSÃO CONTROLADA - reply_cond
+ *
+ * Thread de escrita de uma conexão: envia as respostas na ordem em que
+ * foram enfileiradas e libera a vaga de cada uma. Depois de uma falha de
+ * escrita (cliente fechou o socket), as respostas restantes são descartadas.
+ */
+static void *writer_thread(void *arg)
+{
+    Connection *connection = arg;
+    int connected = 1;
+    pthread_mutex_lock(&connection->mutex);
+    for (;;)
+    {
+        while (!connection->replies && !connection->closing)
+        {
+            pthread_cond_wait(&connection->reply_cond, &connection->mutex);
+        }
+        Request *reply = connection->replies;
+        if (!reply)
+            break;
+        connection->replies = reply->next;
+        if (!connection->replies)
+            connection->replies_tail = NULL;
+        pthread_mutex_unlock(&connection->mutex);
+
+        connected = connected && write_all(connection->fd, reply->header, strlen(reply->header));
+        if (connected && reply->output)
+            connected = write_all(connection->fd, reply->output, reply->output_size);
+        bulkedit_free(reply->output);
+        free(reply);
+
+        pthread_mutex_lock(&connection->mutex);
+        connection->in_flight--;
+        pthread_cond_signal(&connection->idle_cond);
+    }
+    pthread_mutex_unlock(&connection->mutex);
+    return NULL;
+}
+
+/**
+ * @brief Trata um pedido
+ *
+ * @return 1 para continuar lendo a conexão, 0 se o fluxo ficou inconsistente
+ */
+static int handle_request(Connection *connection, FILE *in, char *line)
+{
+    char *save;
+    char *kind = strtok_r(line, " ", &save);
+    char *id = strtok_r(NULL, " ", &save);
+    char *filter = strtok_r(NULL, " ", &save);
+    char *rest = strtok_r(NULL, "", &save);
+    reserve_slot(connection);
+    if (!kind || !id || !filter || !rest || strlen(id) > MAX_REQUEST_ID)
+    {
+        send_error(connection, id && strlen(id) <= MAX_REQUEST_ID ? id : "-", "bad-request");
+        return 1;
+    }
+
+    Request *request = calloc(1, sizeof(Request));
+    if (!request)
+    {
+        release_slot(connection);
+        return 0;
+    }
+    request->connection = connection;
+    strcpy(request->id, id);
+
+    int64_t job = -1;
+    if (strcmp(kind, "P") == 0)
+    {
+        // P <id> <filtro> <entrada>\t<saída>
+        char *tab = strchr(rest, '\t');
+        if (!tab)
+        {
+            free(request);
+            send_error(connection, id, "bad-request");
+            return 1;
+        }
+        *tab = 0;
+        job = bulkedit_submit_path_callback(connection->pool, rest, tab + 1, filter, on_result, request);
+    }
+    else if (strcmp(kind, "B") == 0)
+    {
+        // B <id> <filtro> <tamanho>, seguido dos bytes da imagem
+        char *end;
+        unsigned long long size = strtoull(rest, &end, 10);
+        if (*end || size == 0 || size > MAX_INLINE_SIZE)
+        {
+            free(request);
+            send_error(connection, id, "bad-size");
+            return 0;
+        }
+        request->inline_output = 1;
+        request->input = malloc(size);
+        if (!request->input || fread(request->input, 1, size, in) != size)
+        {
+            free(request->input);
+            free(request);
+            release_slot(connection);
+            return 0;
+        }
+        job = bulkedit_submit_buffer_callback(connection->pool, request->input, size, filter,
+                                              on_result, request);
+    }
+    else
+    {
+        free(request);
+        send_error(connection, id, "bad-request");
+        return 1;
+    }
+
+    if (job < 0)
+    {
+        free(request->input);
+        free(request);
+        send_error(connection, id, "invalid-filter");
+    }
+    return 1;
+}
+
+static void *connection_thread(void *arg)
+{
+    Connection *connection = arg;
+    FILE *in = fdopen(dup(connection->fd), "r");
+    char *line = NULL;
+    size_t line_cap = 0;
+    ssize_t len;
+
+    while (in && (len = getline(&line, &line_cap, in)) > 0)
+    {
+        if (line[len - 1] == '\n')
+            line[--len] = 0;
+        if (len > 0 && line[len - 1] == '\r')
+            line[--len] = 0;
+        if (len == 0)
+            continue;
+        if (!handle_request(connection, in, line))
+            break;
+    }
+    free(line);
+    if (in)
+        fclose(in);
+
+    /*
+     * SUSPENSÃO CONTROLADA - idle_cond
+     *
+     * O cliente parou de enviar pedidos: espera as respostas pendentes serem
+     * escritas antes de encerrar a thread de escrita e fechar o socket
+     */
+    pthread_mutex_lock(&connection->mutex);
+    while (connection->in_flight > 0)
+    {
+        pthread_cond_wait(&connection->idle_cond, &connection->mutex);
+    }
+    connection->closing = 1;
+    pthread_cond_signal(&connection->reply_cond);
+    pthread_mutex_unlock(&connection->mutex);
+    pthread_join(connection->writer, NULL);
+
+    pthread_mutex_lock(&connection->mutex);
+    connection->finished = 1;
+    pthread_mutex_unlock(&connection->mutex);
+
+    shutdown(connection->fd, SHUT_RDWR);
+    return NULL;
+}
+
+static void free_connection(Connection *connection)
+{
+    pthread_join(connection->thread, NULL);
+    close(connection->fd);
+    pthread_mutex_destroy(&connection->mutex);
+    pthread_cond_destroy(&connection->reply_cond);
+    pthread_cond_destroy(&connection->idle_cond);
+    free(connection);
+}
+
+// Coleta as conexões cujas threads já terminaram
+static Connection *reap_connections(Connection *list)
+{
+    Connection **link = &list;
+    while (*link)
+    {
+        Connection *connection = *link;
+        pthread_mutex_lock(&connection->mutex);
+        int finished = connection->finished;
+        pthread_mutex_unlock(&connection->mutex);
+        if (finished)
+        {
+            *link = connection->next;
+            free_connection(connection);
+        }
+        else
+            link = &connection->next;
+    }
+    return list;
+}
+
+static int open_socket(const char *socket_path)
+{
+    struct sockaddr_un address = {0};
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path))
+        return -1;
+    strcpy(address.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+
+    // Um socket deixado por uma execução anterior é substituído
+    unlink(socket_path);
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, LISTEN_BACKLOG) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Modo daemon: atende pedidos por um socket Unix até SIGINT/SIGTERM
+ *
+ * O pool de threads, os pools de buffers de cada thread e o codificador
+ * ficam ativos entre os pedidos, evitando o custo de iniciar um processo
+ * por imagem. Protocolo de linhas (detalhes no README):
+ *   P <id> <filtro> <entrada>\t<saída>    -> OK <id> <pixels>
+ *   B <id> <filtro> <tamanho>\n<bytes>    -> OK <id> <pixels> <tamanho>\n<bytes JPEG>
+ * Falhas respondem "ERR <id> <motivo>". As respostas saem na ordem de conclusão.
+ *
+ * Com num_threads 0, as CPUs disponíveis (cota e cpuset do cgroup) são
+ * relidas a cada CPU_CHECK_MS e o número de threads ativas do pool as
+ * acompanha, pois o daemon pode viver mais do que a configuração do contêiner.
+ *
+ * @param socket_path Caminho do socket
+ * @param num_threads Threads do pool (0 = uma por CPU disponível)
+ * @return 1 se encerrado normalmente, 0 se falha ao iniciar
+ */
+int run_daemon(const char *socket_path, int num_threads)
+{
+    int listen_fd = open_socket(socket_path);
+    if (listen_fd < 0)
+        return 0;
+
+    /*
+     * Os sinais ficam bloqueados fora do ppoll (e nas threads criadas),
+     * como no modo contínuo
+     */
+    struct sigaction action = {0}, old_int, old_term;
+    action.sa_handler = handle_stop_signal;
+    sigemptyset(&action.sa_mask);
+    stop_requested = 0;
+    sigaction(SIGINT, &action, &old_int);
+    sigaction(SIGTERM, &action, &old_term);
+
+    sigset_t stop_signals, old_mask, wait_mask;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, &old_mask);
+    wait_mask = old_mask;
+    sigdelset(&wait_mask, SIGINT);
+    sigdelset(&wait_mask, SIGTERM);
+
+    BulkEditPool *pool = bulkedit_pool_create(num_threads);
+    if (!pool)
+    {
+        pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+        sigaction(SIGINT, &old_int, NULL);
+        sigaction(SIGTERM, &old_term, NULL);
+        close(listen_fd);
+        unlink(socket_path);
+        return 0;
+    }
+    display_daemon_listening(socket_path);
+
+    int active = num_threads ? num_threads : available_cpus();
+    double last_check = now_seconds();
+    const struct timespec check_interval = {CPU_CHECK_MS / 1000, (CPU_CHECK_MS % 1000) * 1000000L};
+
+    Connection *connections = NULL;
+    while (!stop_requested)
+    {
+        struct pollfd pfd = {.fd = listen_fd, .events = POLLIN};
+        int ready = ppoll(&pfd, 1, num_threads ? NULL : &check_interval, &wait_mask);
+        if (ready < 0 && errno != EINTR)
+            break;
+        connections = reap_connections(connections);
+
+        // A cota do cgroup pode mudar com o daemon em execução (ex.: redimensionamento do pod)
+        if (!num_threads && now_seconds() - last_check >= CPU_CHECK_MS / 1000.0)
+        {
+            last_check = now_seconds();
+            int cpus = bulkedit_pool_set_active(pool, available_cpus());
+            if (cpus != active)
+            {
+                active = cpus;
+                display_cpu_limit_change(active);
+            }
+        }
+        if (ready <= 0)
+            continue;
+
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0)
+            continue;
+
+        Connection *connection = calloc(1, sizeof(Connection));
+        if (!connection)
+        {
+            close(fd);
+            continue;
+        }
+        connection->fd = fd;
+        connection->pool = pool;
+        pthread_mutex_init(&connection->mutex, NULL);
+        pthread_cond_init(&connection->reply_cond, NULL);
+        pthread_cond_init(&connection->idle_cond, NULL);
+        if (pthread_create(&connection->writer, NULL, writer_thread, connection) != 0)
+        {
+            close(fd);
+            free(connection);
+            continue;
+        }
+        if (pthread_create(&connection->thread, NULL, connection_thread, connection) != 0)
+        {
+            pthread_mutex_lock(&connection->mutex);
+            connection->closing = 1;
+            pthread_cond_signal(&connection->reply_cond);
+            pthread_mutex_unlock(&connection->mutex);
+            pthread_join(connection->writer, NULL);
+            close(fd);
+            free(connection);
+            continue;
+        }
+        connection->next = connections;
+        connections = connection;
+    }
+
+    /*
+     * Encerramento: novos pedidos deixam de ser lidos, mas as respostas dos
+     * pedidos já submetidos são entregues antes de destruir o pool
+     */
+    close(listen_fd);
+    unlink(socket_path);
+    for (Connection *connection = connections; connection; connection = connection->next)
+        shutdown(connection->fd, SHUT_RD);
+    while (connections)
+    {
+        Connection *next = connections->next;
+        free_connection(connections);
+        connections = next;
+    }
+    bulkedit_pool_destroy(pool);
+
+    pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+    sigaction(SIGINT, &old_int, NULL);
+    sigaction(SIGTERM, &old_term, NULL);
+    return 1;
+}
@@ -0,0 +1,111 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include "file_list.h"
+#include "file_utils.h"
+
+/*
+ * Caminho de saída padrão: <diretório da entrada>_<filtro>/<nome>, a mesma
+ * convenção do modo diretório. Uma entrada na raiz ("/x.jpg") não tem
+ * diretório a que acrescentar o sufixo e é recusada, em vez de gerar um
+ * caminho relativo ao diretório atual.
+ */
+static int default_output_path(const char *input_path, const char *edit_type,
+                               char *output_path, size_t size)
+{
+    const char *slash = strrchr(input_path, '/');
+    int len;
+    if (!slash)
+    {
+        // Nome sem diretório: a entrada está no diretório atual
+        char cwd[PATH_MAX];
+        if (!getcwd(cwd, sizeof(cwd)))
+            return 0;
+        len = snprintf(output_path, size, "%s_%s/%s", cwd, edit_type, input_path);
+    }
+    else if (slash == input_path)
+        return 0;
+    else
+        len = snprintf(output_path, size, "%.*s_%s/%s", (int)(slash - input_path),
+                       input_path, edit_type, slash + 1);
+    return len >= 0 && (size_t)len < size;
+}
+
+/**
+ * @brief Enfileira as imagens de uma lista de caminhos à medida que são lidas
+ *
+ * Cada registro (terminado por `delimiter`, '\n' ou '\0') contém o caminho da
+ * entrada e, com registros por linha, opcionalmente um TAB seguido do caminho
+ * de saída. Com registros separados por NUL (ex.: find -print0) o registro
+ * inteiro é a entrada, já que o nome pode conter TAB. Sem caminho de saída é
+ * usado <diretório da entrada>_<filtro>/<nome>. Os diretórios de saída
+ * são criados conforme aparecem. A lista não é filtrada por extensão: quem a
+ * gera já escolheu os arquivos.
+ *
+ * A leitura acompanha o produtor da lista (ex.: um pipe), e a fila limitada
+ * a `queue_size` imagens aplica contrapressão quando as threads não acompanham.
+ *
+ * @param queue Fila
+ * @param list Arquivo com a lista (pode ser stdin)
+ * @param delimiter Separador de registros
+ * @param edit_type Nome do filtro, usado no caminho de saída padrão
+ * @param queue_size Máximo de imagens aguardando na fila
+ * @return Quantidade de imagens enfileiradas, ou -1 se falha
+ */
+int stream_file_list(Queue *queue, FILE *list, int delimiter, const char *edit_type, int queue_size)
+{
+    if (!queue_reset_stream(queue, queue_size))
+        return -1;
+
+    char *record = NULL;
+    size_t record_cap = 0;
+    ssize_t len;
+    char output_path[PATH_MAX];
+    char last_output_dir[PATH_MAX] = "";
+    int count = 0;
+
+    while ((len = getdelim(&record, &record_cap, delimiter, list)) > 0)
+    {
+        if (record[len - 1] == delimiter)
+            record[--len] = 0;
+        if (delimiter == '\n' && len > 0 && record[len - 1] == '\r')
+            record[--len] = 0;
+        if (len == 0)
+            continue;
+
+        char *tab = delimiter == '\n' ? strchr(record, '\t') : NULL;
+        if (tab)
+        {
+            *tab = 0;
+            snprintf(output_path, sizeof(output_path), "%s", tab + 1);
+        }
+        else if (!default_output_path(record, edit_type, output_path, sizeof(output_path)))
+        {
+            fprintf(stderr, "Sem caminho de saída para %s (muito longo ou na raiz)\n", record);
+            continue;
+        }
+
+        // Listas costumam vir agrupadas por diretório: evita mkdir repetido
+        char *slash = strrchr(output_path, '/');
+        if (slash)
+        {
+            *slash = 0;
+            if (strcmp(output_path, last_output_dir) != 0)
+            {
+                make_dirs(output_path);
+                snprintf(last_output_dir, sizeof(last_output_dir), "%s", output_path);
+            }
+            *slash = '/';
+        }
+
+        if (!queue_push(queue, record, output_path))
+            break;
+        count++;
+    }
+
+    free(record);
+    return count;
+}
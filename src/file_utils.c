@@ -1,9 +1,22 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
 #include "file_utils.h"
 
+#define HASH_CHUNK_SIZE (256 * 1024)
+
+static const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+static const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
 int is_image_file(const char *filename)
 {
     const char *ext = strrchr(filename, '.');
@@ -14,43 +27,588 @@ int is_image_file(const char *filename)
             strcasecmp(ext, ".png") == 0);
 }
 
-ImagePath *scan_directory(const char *input_dir, const char *output_dir, int *count)
+/**
+ * @brief Lista as imagens de um diretório
+ *
+ * Os diretórios e os nomes dos arquivos são guardados em `table`; cada
+ * imagem usa o mesmo nome na entrada e na saída
+ *
+ * @param table Tabela de caminhos da fila
+ * @param input_dir Diretório de entrada
+ * @param output_dir Diretório de saída
+ * @param count Quantidade de imagens encontradas
+ * @return Array de imagens, ou NULL se falha
+ */
+ImagePath *scan_directory(PathTable *table, const char *input_dir, const char *output_dir, int *count)
 {
     DIR *dir = opendir(input_dir);
     if (!dir)
         return NULL;
 
-    struct dirent *entry;
-    *count = 0;
-    while ((entry = readdir(dir)))
+    uint32_t input_index, output_index;
+    if (!path_table_add_dir(table, input_dir, &input_index) ||
+        !path_table_add_dir(table, output_dir, &output_index))
     {
-        if (entry->d_type == DT_REG && is_image_file(entry->d_name))
-        {
-            (*count)++;
-        }
+        closedir(dir);
+        return NULL;
     }
 
-    ImagePath *paths = malloc(*count * sizeof(ImagePath));
+    int capacity = 256;
+    ImagePath *paths = malloc(capacity * sizeof(ImagePath));
     if (!paths)
     {
         closedir(dir);
         return NULL;
     }
 
-    rewinddir(dir);
-    int i = 0;
-    while ((entry = readdir(dir)) && i < *count)
+    struct dirent *entry;
+    *count = 0;
+    while ((entry = readdir(dir)))
     {
-        if (entry->d_type == DT_REG && is_image_file(entry->d_name))
+        if (entry->d_type != DT_REG || !is_image_file(entry->d_name))
+            continue;
+
+        if (*count == capacity)
+        {
+            capacity *= 2;
+            ImagePath *grown = realloc(paths, capacity * sizeof(ImagePath));
+            if (!grown)
+            {
+                free(paths);
+                closedir(dir);
+                return NULL;
+            }
+            paths = grown;
+        }
+
+        ImagePath *path = &paths[*count];
+        memset(path, 0, sizeof(*path));
+        if (!path_table_add_name(table, entry->d_name, &path->name))
         {
-            snprintf(paths[i].input_path, sizeof(paths[i].input_path),
-                     "%s/%s", input_dir, entry->d_name);
-            snprintf(paths[i].output_path, sizeof(paths[i].output_path),
-                     "%s/%s", output_dir, entry->d_name);
-            i++;
+            free(paths);
+            closedir(dir);
+            return NULL;
         }
+        path->input_dir = input_index;
+        path->output_dir = output_index;
+        path->output_name = path->name;
+        (*count)++;
     }
 
     closedir(dir);
     return paths;
-}
\ No newline at end of file
+}
+
+static int compare_by_cost(const void *a, const void *b, void *arg)
+{
+    const PathTable *table = arg;
+    const ImagePath *pa = a;
+    const ImagePath *pb = b;
+    int64_t cost_a = (int64_t)pa->width * pa->height;
+    int64_t cost_b = (int64_t)pb->width * pb->height;
+    if (cost_a != cost_b)
+        return cost_a > cost_b ? -1 : 1;
+    if (pa->size != pb->size)
+        return pa->size > pb->size ? -1 : 1;
+    return strcmp(path_table_name(table, pa->name), path_table_name(table, pb->name));
+}
+
+/**
+ * @brief Ordena as imagens da maior para a menor
+ *
+ * O custo de decodificar, transformar e codificar cresce com o número de
+ * pixels, então as dimensões são lidas apenas do cabeçalho de cada arquivo
+ * e as imagens maiores vão para o início da fila. Assim uma imagem grande
+ * não fica para o final do lote ocupando uma única thread enquanto as
+ * outras ficam ociosas. O tamanho do arquivo desempata.
+ *
+ * @param table Tabela de caminhos das imagens
+ * @param paths Imagens a ordenar
+ * @param count Quantidade de imagens
+ */
+void sort_largest_first(const PathTable *table, ImagePath *paths, int count)
+{
+    char input_path[PATH_MAX];
+    for (int i = 0; i < count; i++)
+    {
+        ImagePath *path = &paths[i];
+        path_table_join(table, path->input_dir, path->name, input_path, sizeof(input_path));
+        if (!probe_image(input_path, &path->width, &path->height))
+            path->width = path->height = 0;
+
+        struct stat st;
+        if (!path->mtime_ns && stat(input_path, &st) == 0)
+        {
+            path->size = st.st_size;
+            path->mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+        }
+    }
+    qsort_r(paths, count, sizeof(ImagePath), compare_by_cost, (void *)table);
+}
+
+static uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t read64(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint64_t xxh64_round(uint64_t acc, uint64_t input)
+{
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static uint64_t xxh64_merge(uint64_t acc, uint64_t val)
+{
+    acc ^= xxh64_round(0, val);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+/*
+ * XXH64: processa 32 bytes por iteração em 4 acumuladores independentes,
+ * o que chega à velocidade de leitura da memória
+ */
+uint64_t hash_bytes(const void *data, size_t len, uint64_t seed)
+{
+    const uint8_t *p = data;
+    const uint8_t *end = p + len;
+    uint64_t h;
+
+    if (len >= 32)
+    {
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+        const uint8_t *limit = end - 32;
+        do
+        {
+            v1 = xxh64_round(v1, read64(p));
+            v2 = xxh64_round(v2, read64(p + 8));
+            v3 = xxh64_round(v3, read64(p + 16));
+            v4 = xxh64_round(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh64_merge(h, v1);
+        h = xxh64_merge(h, v2);
+        h = xxh64_merge(h, v3);
+        h = xxh64_merge(h, v4);
+    }
+    else
+    {
+        h = seed + PRIME64_5;
+    }
+
+    h += (uint64_t)len;
+
+    while (p + 8 <= end)
+    {
+        h ^= xxh64_round(0, read64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+    }
+    if (p + 4 <= end)
+    {
+        h ^= (uint64_t)read32(p) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    while (p < end)
+    {
+        h ^= (*p) * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+/**
+ * @brief Calcula o hash do conteúdo de um arquivo
+ *
+ * O arquivo é lido em blocos e cada bloco usa o hash anterior como semente
+ *
+ * @param path Caminho do arquivo
+ * @param hash Hash resultante
+ * @return 1 se sucesso, 0 se falha de leitura
+ */
+int hash_file(const char *path, uint64_t *hash)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return 0;
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    unsigned char *buffer = malloc(HASH_CHUNK_SIZE);
+    if (!buffer)
+    {
+        close(fd);
+        return 0;
+    }
+
+    uint64_t h = 0;
+    ssize_t n;
+    while ((n = read(fd, buffer, HASH_CHUNK_SIZE)) > 0)
+    {
+        h = hash_bytes(buffer, (size_t)n, h);
+    }
+
+    free(buffer);
+    close(fd);
+    if (n < 0)
+        return 0;
+
+    *hash = h;
+    return 1;
+}
+
+static int compare_by_size(const void *a, const void *b, void *arg)
+{
+    const ImagePath *paths = arg;
+    const ImagePath *pa = &paths[*(const int *)a];
+    const ImagePath *pb = &paths[*(const int *)b];
+    if (pa->size != pb->size)
+        return pa->size < pb->size ? -1 : 1;
+
+    // Hashes ainda não calculados contam como zero
+    uint64_t ha = pa->has_hash ? pa->hash : 0;
+    uint64_t hb = pb->has_hash ? pb->hash : 0;
+    if (ha != hb)
+        return ha < hb ? -1 : 1;
+    return *(const int *)a - *(const int *)b;
+}
+
+/*
+ * Compara dois arquivos byte a byte: hash e tamanho iguais não garantem
+ * conteúdo idêntico
+ */
+static int files_equal(const char *path_a, const char *path_b)
+{
+    int fd_a = open(path_a, O_RDONLY);
+    int fd_b = open(path_b, O_RDONLY);
+    unsigned char *buffer = malloc(2 * HASH_CHUNK_SIZE);
+    unsigned char *other = buffer + HASH_CHUNK_SIZE;
+    int equal = fd_a >= 0 && fd_b >= 0 && buffer;
+    if (equal)
+    {
+        posix_fadvise(fd_a, 0, 0, POSIX_FADV_SEQUENTIAL);
+        posix_fadvise(fd_b, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    while (equal)
+    {
+        ssize_t n = read(fd_a, buffer, HASH_CHUNK_SIZE);
+        if (n <= 0)
+        {
+            // Fim do primeiro arquivo: o segundo também precisa ter terminado
+            equal = n == 0 && read(fd_b, other, 1) == 0;
+            break;
+        }
+
+        ssize_t got = 0;
+        while (got < n)
+        {
+            ssize_t m = read(fd_b, other + got, (size_t)(n - got));
+            if (m <= 0)
+                break;
+            got += m;
+        }
+        equal = got == n && memcmp(buffer, other, (size_t)n) == 0;
+    }
+
+    free(buffer);
+    if (fd_a >= 0)
+        close(fd_a);
+    if (fd_b >= 0)
+        close(fd_b);
+    return equal;
+}
+
+/**
+ * @brief Agrupa entradas com conteúdo idêntico
+ *
+ * Só calcula o hash de arquivos que dividem o tamanho com algum outro, de modo
+ * que diretórios sem duplicatas custam apenas um stat por arquivo; com hash e
+ * tamanho iguais, os arquivos ainda são comparados byte a byte. Ao final,
+ * paths é reordenado: as imagens únicas ficam no início (na ordem original) e
+ * as duplicatas depois, com dup_of apontando para a imagem a ser processada.
+ *
+ * @param table Tabela de caminhos das imagens
+ * @param paths Imagens encontradas
+ * @param count Quantidade de imagens
+ * @return Quantidade de imagens únicas, ou -1 se faltar memória
+ */
+int dedup_images(const PathTable *table, ImagePath *paths, int count)
+{
+    if (count < 2)
+        return count;
+
+    int *order = malloc(count * sizeof(int));
+    int *new_index = malloc(count * sizeof(int));
+    ImagePath *sorted = malloc(count * sizeof(ImagePath));
+    if (!order || !new_index || !sorted)
+    {
+        free(order);
+        free(new_index);
+        free(sorted);
+        return -1;
+    }
+
+    char input_path[PATH_MAX];
+    for (int i = 0; i < count; i++)
+    {
+        struct stat st;
+        path_table_join(table, paths[i].input_dir, paths[i].name, input_path, sizeof(input_path));
+        if (!paths[i].mtime_ns && stat(input_path, &st) == 0)
+        {
+            paths[i].size = st.st_size;
+            paths[i].mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+        }
+        paths[i].dup_of = -1;
+        order[i] = i;
+    }
+
+    qsort_r(order, count, sizeof(int), compare_by_size, paths);
+
+    // Calcula o hash apenas dentro de grupos com o mesmo tamanho
+    for (int start = 0; start < count;)
+    {
+        int end = start + 1;
+        while (end < count && paths[order[end]].size == paths[order[start]].size)
+            end++;
+        if (end - start > 1)
+        {
+            for (int k = start; k < end; k++)
+            {
+                ImagePath *path = &paths[order[k]];
+                if (path->has_hash)
+                    continue;
+                path_table_join(table, path->input_dir, path->name, input_path, sizeof(input_path));
+                path->has_hash = hash_file(input_path, &path->hash);
+            }
+        }
+        start = end;
+    }
+    qsort_r(order, count, sizeof(int), compare_by_size, paths);
+
+    /*
+     * O menor índice de cada grupo idêntico é o que será processado. Dentro
+     * de uma sequência de mesmo tamanho e hash, cada arquivo é comparado com
+     * os originais anteriores da sequência; sem colisões de hash há apenas um
+     */
+    char original_path[PATH_MAX];
+    int run_start = 0;
+    for (int k = 1; k < count; k++)
+    {
+        ImagePath *prev = &paths[order[k - 1]];
+        ImagePath *path = &paths[order[k]];
+        if (!path->has_hash || !prev->has_hash || path->size != prev->size || path->hash != prev->hash)
+        {
+            run_start = k;
+            continue;
+        }
+
+        path_table_join(table, path->input_dir, path->name, input_path, sizeof(input_path));
+        for (int j = run_start; j < k && path->dup_of < 0; j++)
+        {
+            const ImagePath *original = &paths[order[j]];
+            if (original->dup_of >= 0)
+                continue;
+            path_table_join(table, original->input_dir, original->name, original_path, sizeof(original_path));
+            if (files_equal(original_path, input_path))
+                path->dup_of = order[j];
+        }
+    }
+
+    // Reordena: únicas primeiro, duplicatas depois
+    int unique = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (paths[i].dup_of < 0)
+            new_index[i] = unique++;
+    }
+    int next_dup = unique;
+    for (int i = 0; i < count; i++)
+    {
+        if (paths[i].dup_of >= 0)
+            new_index[i] = next_dup++;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        sorted[new_index[i]] = paths[i];
+        if (paths[i].dup_of >= 0)
+            sorted[new_index[i]].dup_of = new_index[paths[i].dup_of];
+    }
+    memcpy(paths, sorted, count * sizeof(ImagePath));
+
+    free(order);
+    free(new_index);
+    free(sorted);
+    return unique;
+}
+
+static int copy_file(const char *source, const char *target)
+{
+    int in = open(source, O_RDONLY);
+    if (in < 0)
+        return 0;
+    int out = open(target, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (out < 0)
+    {
+        close(in);
+        return 0;
+    }
+
+    // Tenta reflink (btrfs/xfs) antes de copiar os bytes
+    int ok = ioctl(out, FICLONE, in) == 0;
+    if (!ok)
+    {
+        char buffer[64 * 1024];
+        ssize_t n;
+        ok = 1;
+        while ((n = read(in, buffer, sizeof(buffer))) > 0)
+        {
+            if (write(out, buffer, n) != n)
+            {
+                ok = 0;
+                break;
+            }
+        }
+        if (n < 0)
+            ok = 0;
+    }
+
+    close(in);
+    ok &= close(out) == 0;
+    return ok;
+}
+
+/**
+ * @brief Materializa a saída de uma duplicata a partir da saída já gerada
+ *
+ * Usa hardlink; se não for possível (ex.: sistemas de arquivos diferentes),
+ * tenta reflink e por último copia o conteúdo
+ *
+ * @return 1 se sucesso, 0 se falha
+ */
+int link_output(const char *source, const char *target)
+{
+    unlink(target);
+    if (link(source, target) == 0)
+        return 1;
+    return copy_file(source, target);
+}
+
+/**
+ * @brief Cria um diretório e os diretórios pais que não existirem (mkdir -p)
+ *
+ * @return 1 se o diretório existe ao final, 0 se falha
+ */
+int make_dirs(const char *dir)
+{
+    char path[PATH_MAX];
+    int len = snprintf(path, sizeof(path), "%s", dir);
+    if (len <= 0 || len >= (int)sizeof(path))
+        return 0;
+
+    for (char *p = path + 1; *p; p++)
+    {
+        if (*p != '/')
+            continue;
+        *p = 0;
+        mkdir(path, 0777);
+        *p = '/';
+    }
+    if (mkdir(path, 0777) == 0)
+        return 1;
+
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+/**
+ * @brief Lê um arquivo inteiro para a memória
+ *
+ * @param path Caminho do arquivo
+ * @param size Recebe o tamanho lido
+ * @return Buffer alocado com malloc (liberar com free), ou NULL se falha
+ */
+unsigned char *read_file(const char *path, size_t *size)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    // Um byte extra evita malloc(0) para arquivos vazios
+    unsigned char *data = malloc((size_t)st.st_size + 1);
+    size_t used = 0;
+    ssize_t n = 0;
+    while (data && used < (size_t)st.st_size &&
+           (n = read(fd, data + used, (size_t)st.st_size - used)) > 0)
+    {
+        used += (size_t)n;
+    }
+    close(fd);
+
+    if (!data || n < 0)
+    {
+        free(data);
+        return NULL;
+    }
+    *size = used;
+    return data;
+}
+
+/**
+ * @brief Grava um buffer como conteúdo de um arquivo (criado ou truncado)
+ *
+ * @return 1 se sucesso, 0 se falha
+ */
+int write_file(const char *path, const unsigned char *data, size_t size)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0)
+        return 0;
+
+    size_t written = 0;
+    while (written < size)
+    {
+        ssize_t n = write(fd, data + written, size - written);
+        if (n <= 0)
+        {
+            close(fd);
+            return 0;
+        }
+        written += (size_t)n;
+    }
+    return close(fd) == 0;
+}
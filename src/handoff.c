@@ -0,0 +1,115 @@
+#include <stdlib.h>
+#include "handoff.h"
+
+void handoff_init(Handoff *handoff)
+{
+    handoff->head = NULL;
+    handoff->tail = NULL;
+    handoff->closed = 0;
+    handoff->waiting = 0;
+    handoff->peak_waiting = 0;
+    pthread_mutex_init(&handoff->mutex, NULL);
+    pthread_cond_init(&handoff->job_cond, NULL);
+}
+
+void handoff_destroy(Handoff *handoff)
+{
+    pthread_mutex_destroy(&handoff->mutex);
+    pthread_cond_destroy(&handoff->job_cond);
+}
+
+/*
+ * SUSPENSÃO CONTROLADA - job_cond
+ *
+ * Acorda todas as threads de processamento para que vejam a flag e terminem
+ */
+void handoff_close(Handoff *handoff)
+{
+    pthread_mutex_lock(&handoff->mutex);
+    handoff->closed = 1;
+    pthread_cond_broadcast(&handoff->job_cond);
+    pthread_mutex_unlock(&handoff->mutex);
+}
+
+/**
+ * @brief Entrega um trabalho ao pool de processamento e espera o resultado
+ *
+ * Chamada pela thread de I/O depois de ler a entrada. Ao retornar, os campos
+ * de saída do trabalho estão preenchidos.
+ *
+ * @param handoff Fila de passagem
+ * @param job Trabalho com a entrada preenchida
+ * @return 1 se o trabalho foi processado, 0 se a fila já estava fechada
+ */
+int handoff_submit(Handoff *handoff, ComputeJob *job)
+{
+    pthread_cond_t done_cond;
+    pthread_cond_init(&done_cond, NULL);
+    job->done = 0;
+    job->done_cond = &done_cond;
+    job->next = NULL;
+
+    pthread_mutex_lock(&handoff->mutex);
+    if (handoff->closed)
+    {
+        pthread_mutex_unlock(&handoff->mutex);
+        pthread_cond_destroy(&done_cond);
+        return 0;
+    }
+
+    if (handoff->tail)
+        handoff->tail->next = job;
+    else
+        handoff->head = job;
+    handoff->tail = job;
+    if (++handoff->waiting > handoff->peak_waiting)
+        handoff->peak_waiting = handoff->waiting;
+    pthread_cond_signal(&handoff->job_cond);
+
+    /*
+     * SUSPENSÃO CONTROLADA - done_cond
+     *
+     * A thread de I/O dorme até a thread de processamento concluir o trabalho
+     */
+    while (!job->done)
+    {
+        pthread_cond_wait(&done_cond, &handoff->mutex);
+    }
+    pthread_mutex_unlock(&handoff->mutex);
+    pthread_cond_destroy(&done_cond);
+    return 1;
+}
+
+/**
+ * @brief Obtém o próximo trabalho para uma thread de processamento
+ *
+ * @return Trabalho em ordem de chegada, ou NULL se a fila foi fechada e esvaziada
+ */
+ComputeJob *handoff_take(Handoff *handoff)
+{
+    pthread_mutex_lock(&handoff->mutex);
+    while (!handoff->head && !handoff->closed)
+    {
+        pthread_cond_wait(&handoff->job_cond, &handoff->mutex);
+    }
+
+    ComputeJob *job = handoff->head;
+    if (job)
+    {
+        handoff->head = job->next;
+        if (!handoff->head)
+            handoff->tail = NULL;
+        handoff->waiting--;
+    }
+    pthread_mutex_unlock(&handoff->mutex);
+    return job;
+}
+
+// Marca o trabalho como concluído e acorda a thread de I/O que o entregou
+void handoff_finish(Handoff *handoff, ComputeJob *job)
+{
+    pthread_mutex_lock(&handoff->mutex);
+    job->done = 1;
+    pthread_cond_signal(job->done_cond);
+    pthread_mutex_unlock(&handoff->mutex);
+}
@@ -1,42 +1,242 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <sys/stat.h>
 #include "img_editing.h"
+#include "file_utils.h"
+#include "timing.h"
+#include "perf_counters.h"
 
-// Bibliotecas
+// Bibliotecas: os buffers do stb vêm do pool da thread e são reaproveitados
+#include "buffer_pool.h"
+#define STBI_MALLOC(size) pool_malloc(size)
+#define STBI_REALLOC_SIZED(ptr, old_size, new_size) pool_realloc(ptr, old_size, new_size)
+#define STBI_FREE(ptr) pool_free(ptr)
+#define STBIW_MALLOC(size) pool_malloc(size)
+#define STBIW_REALLOC_SIZED(ptr, old_size, new_size) pool_realloc(ptr, old_size, new_size)
+#define STBIW_FREE(ptr) pool_free(ptr)
+// stb privado a este arquivo (a libbulkedit.so não exporta stbi_*); as funções não usadas não geram aviso
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#define STB_IMAGE_STATIC
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#define STB_IMAGE_WRITE_STATIC
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
+#pragma GCC diagnostic pop
 
-/*
- * Função principal de transformação de imagem
- */
-int transform_image(const char *input_path, const char *output_path, PixelTransformFunction transform)
-{
-    int width, height, channels;
-    // Carrega a imagem do disco
-    unsigned char *img = stbi_load(input_path, &width, &height, &channels, 3);
-    if (!img)
-        return 0;
+// Capacidade inicial do buffer de codificação em memória
+#define ENCODE_INITIAL_CAPACITY (64 * 1024)
 
-    // Aplica a transformação pixel a pixel
+// Aplica os filtros pixel a pixel sobre uma imagem RGB, em uma única passada
+void apply_transform(unsigned char *img, int width, int height, const Transform *transform)
+{
     for (int i = 0; i < width * height; i++)
     {
-        Pixel input_pixel = {img[i * 3], img[i * 3 + 1], img[i * 3 + 2]};
-        Pixel output_pixel = transform(input_pixel);
+        Pixel output_pixel = {img[i * 3], img[i * 3 + 1], img[i * 3 + 2]};
+        for (int f = 0; f < transform->count; f++)
+            output_pixel = transform->filters[f](output_pixel);
         img[i * 3] = output_pixel.r;
         img[i * 3 + 1] = output_pixel.g;
         img[i * 3 + 2] = output_pixel.b;
     }
+}
 
-    // Salva a imagem transformada
-    int success = stbi_write_jpg(output_path, width, height, 3, img, 100);
+
+/*
+ * Buffer crescente que recebe a saída do codificador JPEG
+ */
+typedef struct
+{
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+    int failed;
+} EncodeBuffer;
+
+static void encode_to_buffer(void *context, void *data, int size)
+{
+    EncodeBuffer *buffer = context;
+    if (buffer->failed)
+        return;
+    if (buffer->size + (size_t)size > buffer->capacity)
+    {
+        size_t capacity = buffer->capacity ? buffer->capacity : ENCODE_INITIAL_CAPACITY;
+        while (capacity < buffer->size + (size_t)size)
+            capacity *= 2;
+        unsigned char *grown = realloc(buffer->data, capacity);
+        if (!grown)
+        {
+            buffer->failed = 1;
+            return;
+        }
+        buffer->data = grown;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->size, data, (size_t)size);
+    buffer->size += (size_t)size;
+}
+
+/**
+ * @brief Transforma uma imagem já lida para a memória, sem acessar o disco
+ *
+ * Decodifica, aplica o filtro e codifica em JPEG; usada pelo pool de
+ * processamento, que recebe os bytes lidos pelo pool de I/O
+ *
+ * @param input Conteúdo do arquivo de entrada
+ * @param input_size Tamanho do conteúdo
+ * @param transform Filtros e qualidade da saída
+ * @param output Recebe o JPEG codificado (liberar com free)
+ * @param output_size Recebe o tamanho do JPEG
+ * @param width Recebe a largura da imagem decodificada (NULL se não interessa)
+ * @param height Recebe a altura da imagem decodificada (NULL se não interessa)
+ * @param pixels Recebe o tamanho da imagem decodificada (largura * altura)
+ * @return 1 se sucesso, 0 se falha
+ */
+int transform_buffer(const unsigned char *input, size_t input_size, const Transform *transform,
+                     unsigned char **output, size_t *output_size, int *width, int *height,
+                     int64_t *pixels)
+{
+    if (input_size > INT_MAX)
+        return 0;
+
+    int image_width, image_height, channels;
+    // Contadores de hardware (--perf) lidos nas mesmas fronteiras das etapas
+    CounterSample counters[4];
+    counters_read(&counters[0]);
+    uint64_t decode_start = timing_now();
+    unsigned char *img = stbi_load_from_memory(input, (int)input_size, &image_width, &image_height,
+                                               &channels, 3);
+    if (!img)
+        return 0;
+    *pixels = (int64_t)image_width * image_height;
+    if (width)
+        *width = image_width;
+    if (height)
+        *height = image_height;
+    uint64_t transform_start = timing_now();
+    counters_read(&counters[1]);
+
+    apply_transform(img, image_width, image_height, transform);
+    counters_read(&counters[2]);
+    uint64_t encode_start = timing_now();
+
+    EncodeBuffer buffer = {0};
+    int success = stbi_write_jpg_to_func(encode_to_buffer, &buffer, image_width, image_height, 3, img,
+                                         transform->quality);
     stbi_image_free(img);
+
+    uint64_t encode_end = timing_now();
+    counters_read(&counters[3]);
+    timing_record(STAGE_DECODE, decode_start, transform_start, *pixels);
+    timing_record(STAGE_TRANSFORM, transform_start, encode_start, *pixels);
+    timing_record(STAGE_ENCODE, encode_start, encode_end, *pixels);
+    counters_record(STAGE_DECODE, &counters[0], &counters[1], *pixels);
+    counters_record(STAGE_TRANSFORM, &counters[1], &counters[2], *pixels);
+    counters_record(STAGE_ENCODE, &counters[2], &counters[3], *pixels);
+    if (!success || buffer.failed)
+    {
+        free(buffer.data);
+        return 0;
+    }
+    *output = buffer.data;
+    *output_size = buffer.size;
+    return 1;
+}
+
+/*
+ * Lê apenas o cabeçalho da imagem para obter suas dimensões, sem decodificar
+ */
+int probe_image(const char *path, int *width, int *height)
+{
+    int channels;
+    return stbi_info(path, width, height, &channels);
+}
+
+/*
+ * Função principal de transformação de imagem
+ *
+ * Lê o arquivo inteiro, transforma em memória e grava o JPEG, de modo que
+ * cada etapa (leitura, decodificação, filtros, codificação e gravação) é
+ * medida separadamente. Em `pixels` retorna o tamanho da imagem decodificada
+ * (largura * altura)
+ */
+int transform_image(const char *input_path, const char *output_path, const Transform *transform,
+                    int64_t *pixels)
+{
+    size_t input_size, output_size;
+    unsigned char *output = NULL;
+    uint64_t read_start = timing_now();
+    unsigned char *input = read_file(input_path, &input_size);
+    if (!input)
+        return 0;
+    uint64_t read_end = timing_now();
+
+    int success = transform_buffer(input, input_size, transform, &output, &output_size, NULL, NULL, pixels);
+    free(input);
+    if (!success)
+        return 0;
+
+    uint64_t write_start = timing_now();
+    success = write_file(output_path, output, output_size);
+    free(output);
+    timing_record(STAGE_READ, read_start, read_end, *pixels);
+    timing_record(STAGE_WRITE, write_start, timing_now(), *pixels);
     return success;
 }
 
+// Filtro correspondente ao nome informado, ou NULL se não existir
+PixelTransformFunction get_transform_function(const char *edit_type)
+{
+    if (strcmp(edit_type, "grayscale") == 0)
+        return grayscale;
+    if (strcmp(edit_type, "red") == 0)
+        return filter_red;
+    if (strcmp(edit_type, "green") == 0)
+        return filter_green;
+    if (strcmp(edit_type, "blue") == 0)
+        return filter_blue;
+    if (strcmp(edit_type, "invert") == 0)
+        return invert;
+    return NULL;
+}
+
+/**
+ * @brief Monta uma transformação a partir de filtros separados por vírgula
+ *
+ * @param spec Nomes dos filtros, aplicados na ordem (ex.: "grayscale,invert")
+ * @param quality Qualidade JPEG da saída (1-100)
+ * @param transform Transformação preenchida
+ * @return 1 se sucesso, 0 se algum filtro não existe ou há filtros demais
+ */
+int parse_transform(const char *spec, int quality, Transform *transform)
+{
+    transform->count = 0;
+    transform->quality = quality;
+
+    char name[32];
+    const char *start = spec;
+    while (1)
+    {
+        size_t len = strcspn(start, ",");
+        if (len == 0 || len >= sizeof(name) || transform->count == MAX_FILTERS)
+            return 0;
+        memcpy(name, start, len);
+        name[len] = 0;
+
+        PixelTransformFunction filter = get_transform_function(name);
+        if (!filter)
+            return 0;
+        transform->filters[transform->count++] = filter;
+
+        if (!start[len])
+            return 1;
+        start += len + 1;
+    }
+}
+
 // Converte um pixel para escala de cinza: Red 21%, Green 72%, Blue 7%
 Pixel grayscale(Pixel pixel)
 {
@@ -0,0 +1,297 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "jobs.h"
+#include "file_utils.h"
+
+/*
+ * Lê um campo "chave=valor" de uma linha do arquivo de jobs
+ *
+ * @return 1 se reconhecido, 0 se chave desconhecida ou valor inválido
+ */
+static int parse_field(Job *job, const char *field)
+{
+    const char *eq = strchr(field, '=');
+    if (!eq || eq == field || !eq[1])
+        return 0;
+    size_t key_len = (size_t)(eq - field);
+    const char *value = eq + 1;
+
+    if (key_len == 5 && strncmp(field, "input", 5) == 0)
+        return (job->input_dir = strdup(value)) != NULL;
+    if (key_len == 6 && strncmp(field, "output", 6) == 0)
+        return (job->output_dir = strdup(value)) != NULL;
+    if (key_len == 6 && strncmp(field, "filter", 6) == 0)
+        return (job->filter = strdup(value)) != NULL;
+    if (key_len == 8 && strncmp(field, "priority", 8) == 0)
+    {
+        char *end;
+        job->priority = (int)strtol(value, &end, 10);
+        return *end == 0;
+    }
+    if (key_len == 7 && strncmp(field, "quality", 7) == 0)
+    {
+        char *end;
+        job->transform.quality = (int)strtol(value, &end, 10);
+        return *end == 0 && job->transform.quality >= 1 && job->transform.quality <= 100;
+    }
+    return 0;
+}
+
+static void free_job(Job *job)
+{
+    free(job->input_dir);
+    free(job->output_dir);
+    free(job->filter);
+    manifest_free(&job->previous);
+    manifest_free(&job->next);
+}
+
+// Maior prioridade primeiro; entre iguais, a ordem do arquivo
+static int compare_jobs(const void *a, const void *b)
+{
+    const Job *ja = a;
+    const Job *jb = b;
+    if (ja->priority != jb->priority)
+        return ja->priority > jb->priority ? -1 : 1;
+    return ja->line - jb->line;
+}
+
+/**
+ * @brief Lê o arquivo de jobs
+ *
+ * Cada linha descreve um job com campos "chave=valor" separados por espaços:
+ * input (obrigatório), filter (obrigatório), output (padrão
+ * <input>_<filter>), priority (padrão 0) e quality (padrão `quality`).
+ * Linhas vazias e iniciadas por '#' são ignoradas. Os jobs são ordenados
+ * pela prioridade, da maior para a menor.
+ *
+ * @param path Caminho do arquivo
+ * @param quality Qualidade JPEG padrão
+ * @param spec Jobs lidos
+ * @return 1 se sucesso, 0 se falha (mensagem em stderr)
+ */
+int load_job_spec(const char *path, int quality, JobSpec *spec)
+{
+    memset(spec, 0, sizeof(*spec));
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        fprintf(stderr, "Erro ao abrir o arquivo de jobs %s\n", path);
+        return 0;
+    }
+
+    char *line = NULL;
+    size_t line_cap = 0;
+    int line_number = 0;
+    int capacity = 0;
+    int ok = 1;
+    while (ok && getline(&line, &line_cap, file) > 0)
+    {
+        line_number++;
+        char *save;
+        char *field = strtok_r(line, " \t\r\n", &save);
+        if (!field || field[0] == '#')
+            continue;
+
+        if (spec->count == MAX_JOBS)
+        {
+            fprintf(stderr, "%s: mais de %d jobs\n", path, MAX_JOBS);
+            ok = 0;
+            break;
+        }
+        if (spec->count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 16;
+            Job *grown = realloc(spec->jobs, capacity * sizeof(Job));
+            if (!grown)
+            {
+                ok = 0;
+                break;
+            }
+            spec->jobs = grown;
+        }
+
+        Job *job = &spec->jobs[spec->count++];
+        memset(job, 0, sizeof(*job));
+        job->line = line_number;
+        job->transform.quality = quality;
+        for (; field; field = strtok_r(NULL, " \t\r\n", &save))
+        {
+            if (!parse_field(job, field))
+            {
+                fprintf(stderr, "%s:%d: campo inválido: %s\n", path, line_number, field);
+                ok = 0;
+                break;
+            }
+        }
+        if (!ok)
+            break;
+
+        int job_quality = job->transform.quality;
+        if (!job->input_dir || !job->filter ||
+            !parse_transform(job->filter, job_quality, &job->transform))
+        {
+            fprintf(stderr, "%s:%d: job requer input e um filter válido\n", path, line_number);
+            ok = 0;
+        }
+    }
+    free(line);
+    fclose(file);
+
+    if (!ok)
+    {
+        job_spec_free(spec);
+        return 0;
+    }
+
+    qsort(spec->jobs, spec->count, sizeof(Job), compare_jobs);
+    return 1;
+}
+
+void job_spec_free(JobSpec *spec)
+{
+    for (int i = 0; i < spec->count; i++)
+        free_job(&spec->jobs[i]);
+    free(spec->jobs);
+    free(spec->transforms);
+    memset(spec, 0, sizeof(*spec));
+}
+
+// Acrescenta as imagens de um job ao fim do array da fila
+static int append_paths(ImagePath **all, int *count, int *capacity, const ImagePath *paths, int n)
+{
+    if (*count + n > *capacity)
+    {
+        int grown_capacity = *capacity ? *capacity : 256;
+        while (grown_capacity < *count + n)
+            grown_capacity *= 2;
+        ImagePath *grown = realloc(*all, grown_capacity * sizeof(ImagePath));
+        if (!grown)
+            return 0;
+        *all = grown;
+        *capacity = grown_capacity;
+    }
+    memcpy(*all + *count, paths, n * sizeof(ImagePath));
+    *count += n;
+    return 1;
+}
+
+/**
+ * @brief Monta uma única fila com as imagens de todos os jobs
+ *
+ * As imagens de cada job ficam contíguas, na ordem de prioridade dos jobs,
+ * e cada uma guarda o índice do seu job para que a trabalhadora aplique a
+ * transformação certa. Assim as threads que terminam a cauda de um job já
+ * seguem para o próximo, sem esperar as demais.
+ *
+ * @param state Estado compartilhado
+ * @param spec Jobs (com o modo incremental, recebem os manifestos)
+ * @return Imagens na fila, ou -1 se falha
+ */
+int queue_jobs(SharedState *state, JobSpec *spec)
+{
+    const Options *opts = state->opts;
+    spec->transforms = malloc((spec->count ? spec->count : 1) * sizeof(Transform));
+    if (!spec->transforms)
+        return -1;
+
+    /*
+     * Varredura, manifestos e ordenação usam uma tabela própria, sem travar
+     * a fila: as trabalhadoras e o controlador seguem livres até o lote ser
+     * publicado por queue_load
+     */
+    PathTable table;
+    path_table_init(&table);
+    ImagePath *all = NULL;
+    int total = 0, capacity = 0;
+    for (int j = 0; j < spec->count; j++)
+    {
+        Job *job = &spec->jobs[j];
+        spec->transforms[j] = job->transform;
+        job->start = total;
+
+        if (!job->output_dir)
+        {
+            char output_dir[PATH_MAX];
+            snprintf(output_dir, sizeof(output_dir), "%s_%s", job->input_dir, job->filter);
+            job->output_dir = strdup(output_dir);
+        }
+
+        int count;
+        ImagePath *paths = scan_directory(&table, job->input_dir, job->output_dir, &count);
+        if (!paths)
+        {
+            job->error = 1;
+            continue;
+        }
+        make_dirs(job->output_dir);
+
+        if (opts->incremental)
+        {
+            if (!manifest_load(&job->previous, job->output_dir))
+            {
+                free(paths);
+                job->error = 1;
+                continue;
+            }
+            char chain[MANIFEST_CHAIN_SIZE];
+            manifest_chain(&job->transform, job->filter, chain, sizeof(chain));
+            count = manifest_select_pending(&job->previous, &job->next, &table, paths, count, chain,
+                                            opts->content_hash);
+            job->skipped = job->next.count;
+        }
+
+        if (opts->order == ORDER_LARGEST_FIRST)
+            sort_largest_first(&table, paths, count);
+
+        for (int i = 0; i < count; i++)
+            paths[i].job = (uint16_t)j;
+
+        int appended = append_paths(&all, &total, &capacity, paths, count);
+        free(paths);
+        if (!appended)
+        {
+            free(all);
+            path_table_free(&table);
+            return -1;
+        }
+        job->count = count;
+    }
+
+    // As transformações ficam visíveis às trabalhadoras pelo mutex de queue_load
+    state->job_transforms = spec->transforms;
+    queue_load(&state->queue, all ? all : malloc(sizeof(ImagePath)), total, 0, &table);
+    return total;
+}
+
+/**
+ * @brief Apura o resultado de cada job após a fila esvaziar e grava os manifestos
+ */
+void finish_jobs(SharedState *state, JobSpec *spec)
+{
+    for (int j = 0; j < spec->count; j++)
+    {
+        Job *job = &spec->jobs[j];
+        const ImagePath *paths = state->queue.paths + job->start;
+        for (int i = 0; i < job->count; i++)
+        {
+            if (paths[i].done)
+                job->processed++;
+            else
+                job->failed++;
+        }
+
+        if (state->opts->incremental && !job->error)
+        {
+            char chain[MANIFEST_CHAIN_SIZE];
+            manifest_chain(&job->transform, job->filter, chain, sizeof(chain));
+            manifest_record_done(&job->next, &state->queue.table, paths, job->count, chain);
+            if (!manifest_save(&job->next, job->output_dir))
+                fprintf(stderr, "Erro ao gravar manifesto de %s\n", job->output_dir);
+        }
+    }
+    state->job_transforms = NULL;
+}
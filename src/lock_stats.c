@@ -0,0 +1,141 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lock_stats.h"
+
+/*
+ * Contadores de uma thread
+ *
+ * Como em timing.c, só a própria thread escreve neles, sem trava nem
+ * operação atômica; os blocos ficam numa lista global (inserção por
+ * compare-and-swap) e são lidos por lock_stats_collect depois que as
+ * threads terminam
+ */
+typedef struct ThreadLockStats
+{
+    LockStats stats;
+    struct ThreadLockStats *next;
+} ThreadLockStats;
+
+static int enabled = 0;
+static ThreadLockStats *all_threads = NULL;
+static __thread ThreadLockStats *local = NULL;
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+// Bloco da thread chamadora, criado no primeiro uso
+static LockStats *thread_stats(void)
+{
+    if (!local)
+    {
+        local = calloc(1, sizeof(ThreadLockStats));
+        if (!local)
+            return NULL;
+        local->stats.role = "outra";
+        local->stats.id = -1;
+        local->next = __atomic_load_n(&all_threads, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&all_threads, &local->next, local, 0, __ATOMIC_RELEASE,
+                                            __ATOMIC_RELAXED))
+            ;
+    }
+    return &local->stats;
+}
+
+/**
+ * @brief Liga a contagem; deve ser chamada antes de criar as threads
+ */
+void lock_stats_enable(void)
+{
+    enabled = 1;
+}
+
+/**
+ * @brief Identifica a thread chamadora no relatório
+ *
+ * @param role Papel da thread (texto estático)
+ * @param id Índice da thread no seu papel
+ */
+void lock_stats_set_thread(const char *role, int id)
+{
+    if (!enabled)
+        return;
+    LockStats *stats = thread_stats();
+    if (stats)
+    {
+        stats->role = role;
+        stats->id = id;
+    }
+}
+
+/**
+ * @brief Trava o mutex, contando a disputa quando a contagem está ligada
+ *
+ * Uma tentativa sem bloqueio separa as travas livres das disputadas; só
+ * estas pagam a leitura do relógio
+ */
+void lock_stats_lock(pthread_mutex_t *mutex)
+{
+    LockStats *stats = enabled ? thread_stats() : NULL;
+    if (!stats)
+    {
+        pthread_mutex_lock(mutex);
+        return;
+    }
+
+    stats->acquisitions++;
+    if (pthread_mutex_trylock(mutex) == 0)
+        return;
+    stats->contended++;
+    uint64_t start = now_ns();
+    pthread_mutex_lock(mutex);
+    stats->wait_ns += now_ns() - start;
+}
+
+/**
+ * @brief pthread_cond_wait contando os despertares
+ *
+ * Deve ser chamada no laço que reavalia a condição, com `woken` iniciado em
+ * 0 antes do laço: se a thread volta a esperar depois de ter acordado, o
+ * despertar anterior não encontrou a condição satisfeita e é contado como
+ * espúrio (sinal perdido para outra thread, broadcast ou despertar do sistema)
+ */
+void lock_stats_wait(pthread_cond_t *cond, pthread_mutex_t *mutex, int *woken)
+{
+    LockStats *stats = enabled ? thread_stats() : NULL;
+    if (stats && *woken)
+        stats->spurious++;
+    pthread_cond_wait(cond, mutex);
+    if (stats)
+        stats->wakeups++;
+    *woken = 1;
+}
+
+/**
+ * @brief Copia os contadores de todas as threads que usaram a fila
+ *
+ * Deve ser chamada depois que as threads medidas terminaram
+ *
+ * @param stats Recebe o vetor (liberar com free), na ordem de criação dos blocos
+ * @return Número de threads, ou 0 se nada foi contado
+ */
+int lock_stats_collect(LockStats **stats)
+{
+    *stats = NULL;
+    int count = 0;
+    ThreadLockStats *head = __atomic_load_n(&all_threads, __ATOMIC_ACQUIRE);
+    for (ThreadLockStats *t = head; t; t = t->next)
+        count++;
+    if (count == 0 || !(*stats = malloc(count * sizeof(LockStats))))
+        return 0;
+
+    // A lista cresce pela cabeça: preenche de trás para frente
+    int i = count;
+    for (ThreadLockStats *t = head; t; t = t->next)
+        (*stats)[--i] = t->stats;
+    return count;
+}
@@ -4,96 +4,204 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <pthread.h>
+#include <signal.h>
 #include <unistd.h>
+#include <limits.h>
+#include <malloc.h>
+#include <dirent.h>
 #include <sys/time.h>
 #include "ui.h"
 #include "img_editing.h"
 #include "file_utils.h"
+#include "manifest.h"
+#include "options.h"
+#include "watch.h"
+#include "file_list.h"
+#include "affinity.h"
+#include "controller.h"
+#include "handoff.h"
+#include "jobs.h"
+#include "daemon.h"
+#include "stream.h"
+#include "pack.h"
+#include "timing.h"
+#include "lock_stats.h"
+#include "trace.h"
+#include "perf_counters.h"
 
-PixelTransformFunction get_transform_function(const char *edit_type)
+// Códigos de saída
+#define EXIT_OK 0
+#define EXIT_ERROR 1   // Opção inválida ou falha que interrompeu a execução
+#define EXIT_PARTIAL 2 // Execução concluída, mas alguma imagem falhou
+
+// Threads criadas por CPU no modo automático (as excedentes ficam suspensas)
+#define AUTO_THREADS_FACTOR 4
+
+// Buffers acima deste tamanho sempre vêm de mmap próprio quando há afinidade
+#define AFFINITY_MMAP_THRESHOLD (1024 * 1024)
+
+/*
+ * Argumento de cada thread trabalhadora: estado compartilhado e seu índice
+ */
+typedef struct
 {
-    if (strcmp(edit_type, "grayscale") == 0)
-        return grayscale;
-    if (strcmp(edit_type, "red") == 0)
-        return filter_red;
-    if (strcmp(edit_type, "green") == 0)
-        return filter_green;
-    if (strcmp(edit_type, "blue") == 0)
-        return filter_blue;
-    if (strcmp(edit_type, "invert") == 0)
-        return invert;
-    return NULL;
+    SharedState *state;
+    int id;
+    Handoff *handoff; // Passagem entre os pools de I/O e de processamento (--io-threads)
+} WorkerArgs;
+
+// Transformação da imagem: a do seu job (--jobs) ou a do filtro atual
+static const Transform *image_transform(const SharedState *state, const ImagePath *path)
+{
+    return state->job_transforms ? &state->job_transforms[path->job] : &state->transform;
 }
 
-ImagePath *get_next_image(SharedState *state)
+/*
+ * Grava o JPEG gerado: no contêiner (--pack), na posição do registro da
+ * imagem, com as dimensões obtidas na decodificação, ou no seu arquivo de saída
+ */
+static int store_output(SharedState *state, int index, const char *output_path, int width, int height,
+                        const unsigned char *output, size_t output_size)
 {
-    pthread_mutex_lock(&state->queue.mutex);
+    if (!state->pack)
+        return write_file(output_path, output, output_size);
 
-    /*
-     * SUSPENSÃO CONTROLADA - queue_cond
-     *
-     * 1. Verifica se fila está vazia (current >= size) ou se programa está terminando
-     * 2. Enquanto não houver trabalho E programa não estiver terminando:
-     *    - Sinaliza outras threads que podem estar esperando (evita deadlocks)
-     *    - Suspende esta thread até que haja trabalho ou programa termine
-    */
-    while (state->queue.current >= state->queue.size && !state->queue.should_exit)
-    {
-        pthread_cond_signal(&state->queue.queue_cond);
-        /*
-         * pthread_cond_wait automaticamente:
-         * 1. Libera o mutex enquanto a thread dorme
-         * 2. Readquire o mutex quando a thread acorda
-        */
-        pthread_cond_wait(&state->queue.queue_cond, &state->queue.mutex);
-    }
+    const char *name = strrchr(output_path, '/');
+    return pack_append(state->pack, (uint32_t)index, name ? name + 1 : output_path, output,
+                       output_size, width, height);
+}
 
-    // Se programa está terminando, retorna NULL para iniciar término da thread
-    if (state->queue.should_exit)
+// Processa uma imagem em memória e grava o resultado no contêiner
+static int pack_image(SharedState *state, int index, const ImagePath *path, const char *input_path,
+                      const char *output_path, int64_t *pixels)
+{
+    size_t input_size, output_size;
+    unsigned char *output = NULL;
+    int width, height;
+    uint64_t read_start = timing_now();
+    unsigned char *input = read_file(input_path, &input_size);
+    uint64_t read_end = timing_now();
+    int success = input && transform_buffer(input, input_size, image_transform(state, path), &output,
+                                            &output_size, &width, &height, pixels);
+    uint64_t write_start = timing_now();
+    success = success && store_output(state, index, output_path, width, height, output, output_size);
+    if (success)
     {
-        pthread_mutex_unlock(&state->queue.mutex);
-        return NULL;
+        timing_record(STAGE_READ, read_start, read_end, *pixels);
+        timing_record(STAGE_WRITE, write_start, timing_now(), *pixels);
     }
+    free(input);
+    free(output);
+    return success;
+}
 
-    // Obtém próxima imagem e incrementa contador atomicamente
-    ImagePath *path = &state->queue.paths[state->queue.current++];
-
-    pthread_mutex_unlock(&state->queue.mutex);
-
-    return path;
+// Intervalo da imagem inteira na trilha da thread (--trace), envolvendo suas etapas
+static void trace_image(const SharedState *state, const ImagePath *path, const char *input_path,
+                        uint64_t start, int success)
+{
+    if (!trace_enabled())
+        return;
+    const char *name = strrchr(input_path, '/');
+    trace_span("imagem", success ? "imagem" : "imagem (falha)", start, timing_now(), "arquivo",
+               name ? name + 1 : input_path, state->job_transforms ? "job" : NULL, path->job);
 }
 
 void *worker_thread(void *arg)
 {
-    SharedState *state = (SharedState *)arg;
+    WorkerArgs *args = (WorkerArgs *)arg;
+    SharedState *state = args->state;
+    ImagePath path;
+    // Caminhos completos montados pela fila para esta thread
+    char input_path[PATH_MAX], output_path[PATH_MAX];
+    lock_stats_set_thread("trabalhadora", args->id);
+    trace_set_thread("trabalhadora", args->id);
 
     while (1)
     {
         // Obtém próxima imagem da fila (thread-safe)
-        ImagePath *path = get_next_image(state);
-        if (!path)  // Retorna NULL quando fila vazia e should_exit=true
+        uint64_t wait_start = timing_now();
+        int index = get_next_image(&state->queue, args->id, &path, input_path, output_path, PATH_MAX);
+        if (index < 0)  // Retorna -1 quando fila vazia e should_exit=true
             break;
+        uint64_t image_start = timing_now();
+        timing_record(STAGE_QUEUE_WAIT, wait_start, image_start, 0);
 
         // Processa imagem!
-        if (transform_image(path->input_path, path->output_path, state->transform))
-        {
-            pthread_mutex_lock(&state->queue.mutex);
-            state->queue.processed++;
+        int64_t pixels = 0;
+        int success = input_path[0] &&
+                      (state->pack ? pack_image(state, index, &path, input_path, output_path, &pixels)
+                                   : transform_image(input_path, output_path, image_transform(state, &path),
+                                                     &pixels));
+        complete_image(&state->queue, index, success, pixels);
+        trace_image(state, &path, input_path, image_start, success);
+    }
+    return NULL;
+}
 
-            /*
-             * SUSPENSÃO CONTROLADA - done_cond
-             *
-             * Se esta foi a última imagem a ser processada (processed == size):
-             * - Sinaliza para a thread principal
-             * - Thread principal pode continuar o fluxo
-            */
-            if (state->queue.processed == state->queue.size)
-            {
-                pthread_cond_signal(&state->queue.done_cond);
-            }
+/*
+ * Thread do pool de I/O: lê a entrada, entrega os bytes ao pool de
+ * processamento e grava o resultado. Passa quase todo o tempo bloqueada
+ * (disco, rede ou aguardando o processamento), sem ocupar CPU.
+ */
+void *io_thread(void *arg)
+{
+    WorkerArgs *args = (WorkerArgs *)arg;
+    SharedState *state = args->state;
+    ImagePath path;
+    char input_path[PATH_MAX], output_path[PATH_MAX];
+    lock_stats_set_thread("io", args->id);
+    trace_set_thread("io", args->id);
+
+    while (1)
+    {
+        uint64_t wait_start = timing_now();
+        int index = get_next_image(&state->queue, args->id, &path, input_path, output_path, PATH_MAX);
+        if (index < 0)
+            break;
+        uint64_t read_start = timing_now();
+        timing_record(STAGE_QUEUE_WAIT, wait_start, read_start, 0);
 
-            pthread_mutex_unlock(&state->queue.mutex);
+        ComputeJob job = {0};
+        unsigned char *input = input_path[0] ? read_file(input_path, &job.input_size) : NULL;
+        uint64_t read_end = timing_now();
+        if (input)
+        {
+            job.input = input;
+            job.transform = image_transform(state, &path);
+            handoff_submit(args->handoff, &job);
+        }
+
+        uint64_t write_start = timing_now();
+        int success = job.success && store_output(state, index, output_path, job.width, job.height,
+                                                  job.output, job.output_size);
+        if (success)
+        {
+            timing_record(STAGE_READ, read_start, read_end, job.pixels);
+            timing_record(STAGE_WRITE, write_start, timing_now(), job.pixels);
         }
+        free(input);
+        free(job.output);
+        complete_image(&state->queue, index, success, job.pixels);
+        trace_image(state, &path, input_path, read_start, success);
+    }
+    return NULL;
+}
+
+/*
+ * Thread do pool de processamento: decodifica, transforma e codifica em
+ * memória os trabalhos entregues pelo pool de I/O, sem tocar no disco
+ */
+void *compute_thread(void *arg)
+{
+    WorkerArgs *args = (WorkerArgs *)arg;
+    ComputeJob *job;
+    trace_set_thread("processamento", args->id);
+
+    while ((job = handoff_take(args->handoff)))
+    {
+        job->success = transform_buffer(job->input, job->input_size, job->transform, &job->output,
+                                        &job->output_size, &job->width, &job->height, &job->pixels);
+        handoff_finish(args->handoff, job);
     }
     return NULL;
 }
@@ -104,81 +212,374 @@ void *worker_thread(void *arg)
  * @param state Estado compartilhado
  * @param input_dir Diretório de entrada
  * @param output_dir Diretório de saída
- * @param new_transform Função de transformação das imagens
+ * @param new_transform Filtros e opções de codificação das imagens
+ * @param chain Chave de filtros e qualidade registrada no manifesto (manifest_chain)
+ * @param previous Manifesto da execução anterior, ou NULL fora do modo incremental
+ * @param next Recebe as entradas já atualizadas que foram puladas
  * @return 1 se sucesso, 0 se falha
  */
 int reload_queue(SharedState *state, const char *input_dir, const char *output_dir,
-                 PixelTransformFunction new_transform)
+                 const Transform *new_transform, const char *chain,
+                 const Manifest *previous, Manifest *next)
 {
-    // Garante que nenhuma thread vai tentar acessar a fila durante a recarga
-    pthread_mutex_lock(&state->queue.mutex);
-
-    // Libera recursos da fila anterior se existir
-    free(state->queue.paths);
+    /*
+     * O lote é montado sem o mutex da fila: a varredura, o manifesto e a
+     * leitura dos cabeçalhos para a ordenação acessam o disco, e o lote só
+     * substitui o anterior em queue_load
+     */
+    PathTable table;
+    path_table_init(&table);
 
     // Busca imagens no diretório de entrada
     int count;
-    state->queue.paths = scan_directory(input_dir, output_dir, &count);
-    if (!state->queue.paths)
+    ImagePath *paths = scan_directory(&table, input_dir, output_dir, &count);
+    if (!paths)
     {
-        // Em caso de falha, libera mutex e retorna erro (0)
-        pthread_mutex_unlock(&state->queue.mutex);
+        path_table_free(&table);
         return 0;
     }
 
-    // Reinicializa estado
-    state->queue.size = count;
-    state->queue.current = 0;
-    state->queue.processed = 0;
-    state->transform = new_transform;
+    // Modo incremental: mantém na fila apenas as imagens novas ou alteradas
+    if (previous)
+    {
+        count = manifest_select_pending(previous, next, &table, paths, count, chain,
+                                        state->opts->content_hash);
+    }
 
     /*
-     * SUSPENSÃO CONTROLADA - queue_cond
-     * 
-     * Acorda TODAS as threads trabalhadoras esperando por trabalho
+     * ESCALONAMENTO
+     *
+     * Maiores imagens primeiro: reduz a cauda do lote em que poucas threads
+     * trabalham. A deduplicação a seguir preserva esta ordem. Com --order
+     * dir os cabeçalhos não são lidos.
      */
-    pthread_cond_broadcast(&state->queue.queue_cond);
+    if (state->opts->order == ORDER_LARGEST_FIRST)
+        sort_largest_first(&table, paths, count);
 
-    pthread_mutex_unlock(&state->queue.mutex);
+    /*
+     * DEDUPLICAÇÃO
+     *
+     * Cópias idênticas ficam após as imagens únicas e não entram na fila;
+     * suas saídas são ligadas à saída da original ao fim do processamento
+     */
+    int duplicates = 0;
+    if (state->opts->dedup)
+    {
+        int unique = dedup_images(&table, paths, count);
+        if (unique >= 0)
+        {
+            duplicates = count - unique;
+            count = unique;
+        }
+    }
 
+    // A transformação fica visível às trabalhadoras pelo mutex de queue_load
+    state->transform = *new_transform;
+    queue_load(&state->queue, paths, count, duplicates, &table);
     return 1;
 }
 
+/**
+ * @brief Gera as saídas das duplicatas a partir das saídas já processadas
+ *
+ * @param queue Fila com as duplicatas após as imagens únicas
+ * @return Quantidade de duplicatas materializadas
+ */
+int materialize_duplicates(Queue *queue)
+{
+    char original_input[PATH_MAX], original_output[PATH_MAX];
+    char dup_input[PATH_MAX], dup_output[PATH_MAX];
+    int linked = 0;
+    for (int i = queue->size; i < queue->size + queue->duplicates; i++)
+    {
+        ImagePath *dup = &queue->paths[i];
+        const ImagePath *original = &queue->paths[dup->dup_of];
+        if (original->done &&
+            image_paths(&queue->table, original, original_input, original_output, PATH_MAX) &&
+            image_paths(&queue->table, dup, dup_input, dup_output, PATH_MAX) &&
+            link_output(original_output, dup_output))
+        {
+            dup->done = 1;
+            linked++;
+        }
+    }
+    return linked;
+}
+
+/**
+ * @brief Executa todos os jobs do arquivo de jobs em uma única passagem do pool
+ *
+ * @param state Estado compartilhado
+ * @param summary Recebe falhas e imagens ignoradas
+ * @return Total de imagens processadas
+ */
+int run_job_file(SharedState *state, RunSummary *summary)
+{
+    const Options *opts = state->opts;
+    JobSpec spec;
+    if (!load_job_spec(opts->job_file, opts->quality, &spec))
+    {
+        summary->status = EXIT_ERROR;
+        return 0;
+    }
+
+    struct timeval start_time;
+    gettimeofday(&start_time, NULL);
+    uint64_t trace_start = timing_now();
+
+    if (queue_jobs(state, &spec) < 0)
+    {
+        fprintf(stderr, "Erro ao montar a fila dos jobs\n");
+        summary->status = EXIT_ERROR;
+        job_spec_free(&spec);
+        return 0;
+    }
+
+    lock_stats_lock(&state->queue.mutex);
+    queue_wait_done(&state->queue);
+    int queued = state->queue.size;
+    pthread_mutex_unlock(&state->queue.mutex);
+    trace_span("lote", "jobs", trace_start, timing_now(), "arquivo", opts->job_file, "imagens", queued);
+
+    struct timeval end_time;
+    gettimeofday(&end_time, NULL);
+    state->queue.total_time += (end_time.tv_sec - start_time.tv_sec) +
+                               (end_time.tv_usec - start_time.tv_usec) / 1e6;
+
+    finish_jobs(state, &spec);
+    int processed = 0;
+    for (int j = 0; j < spec.count; j++)
+    {
+        const Job *job = &spec.jobs[j];
+        display_job_result(job->input_dir, job->filter, job->output_dir, job->processed,
+                           job->failed, job->skipped, job->error);
+        processed += job->processed;
+        summary->failed += job->failed;
+        summary->skipped += job->skipped;
+        if (job->error)
+            summary->status = EXIT_PARTIAL;
+    }
+    job_spec_free(&spec);
+    return processed;
+}
+
 /**
  * @brief Processamento paralelo de imagens
  *
- * @param input_dir Diretório com as imagens originais
- * @param num_threads Número de threads trabalhadoras a serem criadas
+ * @param input_dir Diretório com as imagens originais (NULL no modo lista)
+ * @param num_threads Número de threads trabalhadoras, THREADS_AUTO ou THREADS_DEFAULT
+ * @param opts Opções da linha de comando
+ * @param summary Recebe o resumo da execução
  * @return Total de imagens processadas
  */
-int process_directory_parallel(const char *input_dir, int num_threads)
+int process_directory_parallel(const char *input_dir, int num_threads, const Options *opts,
+                               RunSummary *summary)
 {
     SharedState state = {0};
-    // Inicializando objetos de sincronização
-    pthread_mutex_init(&state.queue.mutex, NULL);
-    pthread_cond_init(&state.queue.queue_cond, NULL);
-    pthread_cond_init(&state.queue.done_cond, NULL);
-    state.queue.should_exit = 0;
-    state.queue.total_time = 0.0;
+    state.opts = opts;
+    queue_init(&state.queue);
+    lock_stats_set_thread("principal", 0);
+    trace_set_thread("principal", 0);
+
+    /*
+     * CONCORRÊNCIA AUTOMÁTICA
+     *
+     * As threads são criadas para as CPUs permitidas (afinidade/cpuset), mas
+     * apenas uma por CPU disponível segundo a cota do cgroup começa ativa.
+     * - auto: AUTO_THREADS_FACTOR threads por CPU; o controlador ajusta o
+     *   limite pela vazão
+     * - padrão: uma thread por CPU; o controlador acompanha mudanças de cota
+     */
+    /*
+     * POOLS DE I/O E DE PROCESSAMENTO
+     *
+     * Com --io-threads, a leitura e a gravação ficam com um pool próprio, que
+     * pode ser grande para esconder a latência (ex.: armazenamento em rede),
+     * enquanto o pool de processamento fica limitado às CPUs. O número de
+     * threads de processamento é fixo: o controlador não ajusta este modo.
+     */
+    int io_threads = opts->io_threads;
+    if (io_threads && (num_threads == THREADS_AUTO || num_threads == THREADS_DEFAULT))
+        num_threads = available_cpus();
+
+    int controlled_threads = num_threads == THREADS_AUTO || num_threads == THREADS_DEFAULT;
+    int hill_climb = num_threads == THREADS_AUTO;
+    int threads_per_cpu = hill_climb ? AUTO_THREADS_FACTOR : 1;
+    if (controlled_threads)
+        num_threads = allowed_cpus() * threads_per_cpu;
 
     /*
      * POOL DE THREADS
      *
      * Cada thread executa `worker_thread` com o mesmo estado compartilhado
      */
-    pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
-    for (int i = 0; i < num_threads; i++)
+    pthread_t *threads = malloc((num_threads + io_threads) * sizeof(pthread_t));
+    WorkerArgs *worker_args = malloc((num_threads + io_threads) * sizeof(WorkerArgs));
+
+    // Trabalhadoras herdam SIGINT/SIGTERM bloqueados: só a thread principal os recebe
+    sigset_t stop_signals, old_mask;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, &old_mask);
+
+    /*
+     * AFINIDADE
+     *
+     * Com --affinity cada thread nasce fixada em uma CPU. Como a política
+     * padrão do kernel aloca a página no nó NUMA de quem a toca primeiro, os
+     * buffers que a thread decodifica, transforma e codifica ficam no seu nó.
+     * O limiar fixo de mmap impede que o malloc reaproveite para um buffer
+     * grande memória já tocada por uma thread de outro nó.
+     */
+    int *cpus = NULL;
+    if (opts->affinity)
+    {
+        cpus = malloc(num_threads * sizeof(int));
+        if (!cpus || !affinity_plan(opts->affinity, num_threads, cpus))
+        {
+            fprintf(stderr, "Afinidade inválida: %s (threads não serão fixadas)\n", opts->affinity);
+            free(cpus);
+            cpus = NULL;
+        }
+        else
+        {
+            mallopt(M_MMAP_THRESHOLD, AFFINITY_MMAP_THRESHOLD);
+            display_affinity(cpus, num_threads);
+        }
+    }
+
+    /*
+     * PASSAGEM POR NÓ NUMA
+     *
+     * Com --affinity, há uma fila de passagem por nó usado pelas threads de
+     * processamento: a thread de I/O entrega o buffer que leu (alocado no seu
+     * nó) à fila do seu nó, e só as threads de processamento fixadas nele o
+     * decodificam. Se algum nó ficar sem thread de I/O (menos threads de I/O
+     * do que nós), todas usam uma única fila, para não deixar CPUs ociosas.
+     */
+    int handoff_count = 1;
+    int *compute_group = NULL; // Fila de cada thread de processamento (NULL = fila única)
+    int *io_group = NULL;      // Fila de cada thread de I/O
+    if (io_threads && cpus)
+    {
+        compute_group = malloc(num_threads * sizeof(int));
+        io_group = malloc(io_threads * sizeof(int));
+        int *io_per_group = calloc(num_threads, sizeof(int));
+        int groups = compute_group && io_group && io_per_group
+                         ? affinity_node_groups(cpus, num_threads, compute_group)
+                         : 0;
+        for (int i = 0; i < io_threads && groups > 0; i++)
+        {
+            io_group[i] = compute_group[(int64_t)i * num_threads / io_threads];
+            io_per_group[io_group[i]]++;
+        }
+        for (int g = 0; g < groups; g++)
+            if (io_per_group[g] == 0)
+                groups = 0;
+        free(io_per_group);
+        if (groups > 1)
+            handoff_count = groups;
+        else
+        {
+            free(compute_group);
+            free(io_group);
+            compute_group = io_group = NULL;
+        }
+    }
+    Handoff *handoffs = NULL;
+    if (io_threads)
+    {
+        handoffs = malloc(handoff_count * sizeof(Handoff));
+        for (int g = 0; g < handoff_count; g++)
+            handoff_init(&handoffs[g]);
+    }
+
+    // Só as threads criadas são aguardadas no fim; se uma falhar, nenhuma outra é criada
+    int created_workers = 0;
+    for (int i = 0; i < num_threads && created_workers == i; i++)
+    {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        if (cpus)
+        {
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            CPU_SET(cpus[i], &cpu_set);
+            pthread_attr_setaffinity_np(&attr, sizeof(cpu_set), &cpu_set);
+        }
+        worker_args[i].state = &state;
+        worker_args[i].id = i;
+        worker_args[i].handoff = handoffs ? &handoffs[compute_group ? compute_group[i] : 0] : NULL;
+        if (pthread_create(&threads[i], &attr, io_threads ? compute_thread : worker_thread,
+                           &worker_args[i]) == 0)
+            created_workers++;
+        pthread_attr_destroy(&attr);
+    }
+
+    /*
+     * Threads de I/O não são fixadas em uma CPU (passam o tempo bloqueadas),
+     * mas com --affinity ficam no nó NUMA das threads de processamento,
+     * distribuídas na mesma proporção que elas entre os nós
+     */
+    int created_io = 0;
+    for (int i = 0; i < io_threads && created_workers == num_threads && created_io == i; i++)
+    {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        cpu_set_t node_cpus;
+        if (cpus && affinity_node_cpus(cpus[(int64_t)i * num_threads / io_threads], &node_cpus) > 0)
+            pthread_attr_setaffinity_np(&attr, sizeof(node_cpus), &node_cpus);
+        WorkerArgs *io_args = &worker_args[num_threads + i];
+        io_args->state = &state;
+        io_args->id = i;
+        io_args->handoff = &handoffs[io_group ? io_group[i] : 0];
+        if (pthread_create(&threads[num_threads + i], &attr, io_thread, io_args) == 0)
+            created_io++;
+        pthread_attr_destroy(&attr);
+    }
+
+    // Sem o pool completo nada é processado: as threads criadas encontram a fila encerrada
+    int started = created_workers == num_threads && created_io == io_threads;
+    if (!started)
     {
-        pthread_create(&threads[i], NULL, worker_thread, &state);
+        fprintf(stderr, "Falha ao criar as threads (%d de %d trabalhadoras, %d de %d de I/O)\n",
+                created_workers, num_threads, created_io, io_threads);
+        queue_shutdown(&state.queue);
     }
 
+    Controller controller;
+    int controlled = started && controlled_threads &&
+                     controller_start(&controller, &state.queue, num_threads, hill_climb, threads_per_cpu);
+    pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+    free(cpus);
+    free(compute_group);
+    free(io_group);
+
     char *edit_type = NULL;
-    char output_dir[256];
+    char output_dir[PATH_MAX];
     int total_processed = 0;
+    memset(summary, 0, sizeof(*summary));
+    // Modos que recebem as imagens aos poucos e executam um único filtro
+    int streaming = opts->watch || opts->file_list;
 
-    edit_type = get_edit_type();
+    /*
+     * ARQUIVO DE JOBS
+     *
+     * Todos os jobs entram em uma única fila, e o pool fica ocupado até o
+     * último; sem jobs, segue o fluxo de um filtro por vez
+     */
+    if (!started)
+        summary->status = EXIT_ERROR;
+    else if (opts->job_file)
+    {
+        total_processed = run_job_file(&state, summary);
+        queue_shutdown(&state.queue);
+    }
+    else
+        edit_type = opts->filter ? strdup(opts->filter) : get_edit_type();
 
-    while (1)
+    while (edit_type)
     {
         /*
          * SUSPENSÃO CONTROLADA - queue_cond
@@ -191,49 +592,143 @@ int process_directory_parallel(const char *input_dir, int num_threads)
         */
         if (strcmp(edit_type, "sair") == 0)
         {
-            pthread_mutex_lock(&state.queue.mutex);
-            state.queue.should_exit = 1;
-            pthread_cond_broadcast(&state.queue.queue_cond);
-            pthread_mutex_unlock(&state.queue.mutex);
-
+            queue_shutdown(&state.queue);
             free(edit_type);
             break;
         }
 
-        PixelTransformFunction transform = get_transform_function(edit_type);
-        if (!transform)
+        Transform transform;
+        if (!parse_transform(edit_type, opts->quality, &transform))
         {
-            printf("Tipo de edição inválido: %s\n", edit_type);
+            fprintf(stderr, "Tipo de edição inválido: %s\n", edit_type);
             free(edit_type);
+            if (opts->filter)
+            {
+                summary->status = EXIT_ERROR;
+                queue_shutdown(&state.queue);
+                break;
+            }
             edit_type = get_edit_type();
             continue;
         }
+        char chain[MANIFEST_CHAIN_SIZE];
+        manifest_chain(&transform, edit_type, chain, sizeof(chain));
 
-        snprintf(output_dir, sizeof(output_dir), "%s_%s", input_dir, edit_type);
-        mkdir(output_dir, 0777);
+        /*
+         * CONTÊINER DE SAÍDA
+         *
+         * Com --pack as imagens vão para um único arquivo de dados e seu
+         * índice; o diretório de saída só dá nome às imagens e não é criado
+         */
+        Pack pack;
+        if (opts->pack)
+        {
+            snprintf(output_dir, sizeof(output_dir), "%s_%s", input_dir, edit_type);
+            if (!pack_create(&pack, opts->pack))
+            {
+                fprintf(stderr, "Erro ao criar o contêiner %s\n", opts->pack);
+                summary->status = EXIT_ERROR;
+                queue_shutdown(&state.queue);
+                free(edit_type);
+                break;
+            }
+            state.pack = &pack;
+        }
+        else if (input_dir && opts->output_dir)
+        {
+            snprintf(output_dir, sizeof(output_dir), "%s", opts->output_dir);
+            make_dirs(output_dir);
+        }
+        else if (input_dir)
+        {
+            snprintf(output_dir, sizeof(output_dir), "%s_%s", input_dir, edit_type);
+            mkdir(output_dir, 0777);
+        }
 
         // Registra tempo de início desta edição
         struct timeval start_time;
         gettimeofday(&start_time, NULL);
+        uint64_t trace_start = timing_now();
 
-        if (!reload_queue(&state, input_dir, output_dir, transform))
+        /*
+         * MODO CONTÍNUO
+         *
+         * As threads trabalhadoras recebem as imagens à medida que chegam no
+         * diretório, até o usuário interromper (Ctrl+C)
+         */
+        Manifest previous, next = {0};
+        if (opts->watch)
         {
-            printf("Erro ao recarregar fila\n");
-            free(edit_type);
-            break;
+            state.transform = transform;
+            if (!watch_directory(&state.queue, input_dir, output_dir,
+                                 opts->queue_size, opts->debounce_ms))
+            {
+                fprintf(stderr, "Erro ao monitorar %s\n", input_dir);
+                summary->status = EXIT_ERROR;
+                queue_shutdown(&state.queue);
+                free(edit_type);
+                break;
+            }
         }
-
         /*
-         * SUSPENSÃO CONTROLADA - done_cond
+         * LISTA DE ARQUIVOS
          *
-         * Thread principal dorme até que a última thread a processar uma imagem envie esse sinal
+         * Os caminhos são enfileirados conforme a lista é lida, sem varrer diretórios
          */
-        pthread_mutex_lock(&state.queue.mutex);
-        while (state.queue.processed < state.queue.size && !state.queue.should_exit)
+        else if (opts->file_list)
+        {
+            state.transform = transform;
+            FILE *list = strcmp(opts->file_list, "-") == 0 ? stdin : fopen(opts->file_list, "r");
+            int listed = list ? stream_file_list(&state.queue, list, opts->list_delimiter,
+                                                 edit_type, opts->queue_size)
+                              : -1;
+            if (list && list != stdin)
+                fclose(list);
+            if (listed < 0)
+            {
+                fprintf(stderr, "Erro ao ler a lista %s\n", opts->file_list);
+                summary->status = EXIT_ERROR;
+                queue_shutdown(&state.queue);
+                free(edit_type);
+                break;
+            }
+        }
+        else
         {
-            pthread_cond_wait(&state.queue.done_cond, &state.queue.mutex);
+            /*
+             * MODO INCREMENTAL
+             *
+             * O manifesto do diretório de saída indica quais entradas já foram
+             * processadas com este filtro; somente as demais entram na fila
+             */
+            if (opts->incremental && !manifest_load(&previous, output_dir))
+            {
+                fprintf(stderr, "Erro ao ler manifesto de %s\n", output_dir);
+                summary->status = EXIT_ERROR;
+                queue_shutdown(&state.queue);
+                manifest_free(&previous);
+                free(edit_type);
+                break;
+            }
+
+            if (!reload_queue(&state, input_dir, output_dir, &transform, chain,
+                              opts->incremental ? &previous : NULL, &next))
+            {
+                fprintf(stderr, "Erro ao recarregar fila\n");
+                summary->status = EXIT_ERROR;
+                queue_shutdown(&state.queue);
+                if (opts->incremental)
+                    manifest_free(&previous);
+                free(edit_type);
+                break;
+            }
         }
 
+        lock_stats_lock(&state.queue.mutex);
+        queue_wait_done(&state.queue);
+        trace_span("lote", "lote", trace_start, timing_now(), "filtro", edit_type, "imagens",
+                   state.queue.size);
+
         // Calcula tempo gasto nesta edição
         struct timeval end_time;
         gettimeofday(&end_time, NULL);
@@ -243,38 +738,337 @@ int process_directory_parallel(const char *input_dir, int num_threads)
 
         state.queue.total_time += elapsed; // Total acumulado
         total_processed += state.queue.processed;
+        summary->failed += state.queue.failed;
 
         display_processing_result(edit_type, state.queue.processed, elapsed);
 
         pthread_mutex_unlock(&state.queue.mutex);
 
+        // O cabeçalho do índice só é gravado após a última imagem
+        if (state.pack)
+        {
+            if (!pack_finish(&pack, (uint32_t)state.queue.size))
+            {
+                fprintf(stderr, "Erro ao gravar o contêiner %s\n", opts->pack);
+                summary->status = EXIT_ERROR;
+            }
+            state.pack = NULL;
+        }
+
+        if (state.queue.duplicates > 0)
+        {
+            int linked = materialize_duplicates(&state.queue);
+            total_processed += linked;
+            summary->duplicates += linked;
+            display_duplicates(linked, state.queue.duplicates);
+        }
+
+        if (opts->incremental)
+        {
+            display_skipped_images(next.count);
+            summary->skipped += next.count;
+            manifest_record_done(&next, &state.queue.table, state.queue.paths,
+                                 state.queue.size + state.queue.duplicates, chain);
+            if (!manifest_save(&next, output_dir))
+                fprintf(stderr, "Erro ao gravar manifesto de %s\n", output_dir);
+            manifest_free(&previous);
+        }
+        manifest_free(&next);
+
+        if (streaming || opts->filter)
+        {
+            queue_shutdown(&state.queue);
+            free(edit_type);
+            break;
+        }
+
         free(edit_type);
         edit_type = get_edit_type();
     }
 
-    for (int i = 0; i < num_threads; i++)
+    if (controlled)
+        controller_stop(&controller);
+
+    /*
+     * As threads de I/O terminam com a fila; só então a passagem é fechada,
+     * pois até lá ainda podem entregar trabalhos ao pool de processamento
+     */
+    for (int i = 0; i < created_io; i++)
+    {
+        pthread_join(threads[num_threads + i], NULL);
+    }
+    for (int g = 0; g < handoff_count && io_threads; g++)
+        handoff_close(&handoffs[g]);
+
+    for (int i = 0; i < created_workers; i++)
     {
         pthread_join(threads[i], NULL);
     }
 
-    display_final_statistics(total_processed, state.queue.total_time, num_threads);
+    summary->processed = total_processed;
+    summary->pixels = state.queue.pixels;
+    summary->elapsed = state.queue.total_time;
+    summary->threads = num_threads;
+    summary->io_threads = io_threads;
+    if (summary->status == EXIT_OK && summary->failed > 0)
+        summary->status = EXIT_PARTIAL;
+
+    display_final_statistics(summary);
+    if (io_threads)
+    {
+        int peak_waiting = 0;
+        for (int g = 0; g < handoff_count; g++)
+        {
+            if (handoffs[g].peak_waiting > peak_waiting)
+                peak_waiting = handoffs[g].peak_waiting;
+            handoff_destroy(&handoffs[g]);
+        }
+        display_io_pool(io_threads, handoff_count, peak_waiting);
+        free(handoffs);
+    }
+    if (controlled)
+        display_controller_summary(controller.active, controller.peak, num_threads,
+                                   controller.adjustments);
 
-    // Destruindo objetos de sincronização
-    pthread_mutex_destroy(&state.queue.mutex);
-    pthread_cond_destroy(&state.queue.queue_cond);
-    pthread_cond_destroy(&state.queue.done_cond);
+    queue_destroy(&state.queue);
+    free(worker_args);
     free(threads);
     
     return total_processed;
 }
 
-int main()
+/**
+ * @brief Abre a origem e o destino dos modos fluxo e tar e executa o fluxo
+ *
+ * @return Código de saída
+ */
+static int run_stream_mode(const Options *opts, RunSummary *summary)
+{
+    memset(summary, 0, sizeof(*summary));
+    StreamEnds ends = {0};
+    char output_dir[PATH_MAX];
+    if (opts->stream)
+    {
+        set_report_stream(stderr);
+        ends.in = stdin;
+        ends.out = stdout;
+        ends.in_format = ends.out_format = opts->stream;
+    }
+    else
+    {
+        if (opts->tar_input)
+        {
+            ends.in = fopen(opts->tar_input, "rb");
+            ends.in_format = STREAM_TAR;
+            if (!ends.in)
+            {
+                fprintf(stderr, "Erro ao abrir o tar %s\n", opts->tar_input);
+                return EXIT_ERROR;
+            }
+        }
+        else
+        {
+            DIR *dir = opendir(opts->input_dir);
+            if (!dir)
+            {
+                fprintf(stderr, "Diretório não encontrado: %s\n", opts->input_dir);
+                return EXIT_ERROR;
+            }
+            closedir(dir);
+            ends.input_dir = opts->input_dir;
+        }
+
+        if (opts->tar_output)
+        {
+            ends.out = fopen(opts->tar_output, "wb");
+            ends.out_format = STREAM_TAR;
+        }
+        else
+        {
+            // Padrão <tar sem extensão>_<filtro>, como nos diretórios
+            const char *base = opts->tar_input;
+            size_t len = strlen(base);
+            if (len > 4 && strcmp(base + len - 4, ".tar") == 0)
+                len -= 4;
+            if (opts->output_dir)
+                snprintf(output_dir, sizeof(output_dir), "%s", opts->output_dir);
+            else
+                snprintf(output_dir, sizeof(output_dir), "%.*s_%s", (int)len, base, opts->filter);
+            ends.output_dir = output_dir;
+        }
+        if ((opts->tar_output && !ends.out) || (ends.output_dir && !make_dirs(ends.output_dir)))
+        {
+            fprintf(stderr, "Erro ao criar a saída %s\n",
+                    opts->tar_output ? opts->tar_output : output_dir);
+            if (ends.in)
+                fclose(ends.in);
+            return EXIT_ERROR;
+        }
+    }
+
+    int ok = run_stream(&ends, opts, summary);
+    if (!opts->stream)
+    {
+        if (ends.in)
+            fclose(ends.in);
+        if (ends.out && fclose(ends.out) != 0)
+            ok = 0;
+    }
+    if (!ok)
+        return EXIT_ERROR;
+    return summary->failed > 0 ? EXIT_PARTIAL : EXIT_OK;
+}
+
+// Relatório das etapas medidas com --timings, após o término das threads
+static void report_timings(const Options *opts)
+{
+    if (opts->timings == TIMINGS_NONE)
+        return;
+    StageStats stats[STAGE_COUNT];
+    timing_collect(stats);
+    if (opts->timings == TIMINGS_JSON)
+        display_stage_timings_json(stats);
+    else
+        display_stage_timings(stats);
+}
+
+// Disputa da fila contada com --lock-stats, após o término das threads
+static void report_lock_stats(const Options *opts)
+{
+    if (opts->lock_stats == TIMINGS_NONE)
+        return;
+    LockStats *stats;
+    int count = lock_stats_collect(&stats);
+    if (opts->lock_stats == TIMINGS_JSON)
+        display_lock_stats_json(stats, count);
+    else
+        display_lock_stats(stats, count);
+    free(stats);
+}
+
+// Contadores de hardware lidos com --perf, após o término das threads
+static void report_counters(const Options *opts)
 {
-    char *input_dir = get_input_directory();
-    int num_threads = get_thread_count();
+    if (opts->perf == TIMINGS_NONE)
+        return;
+    StageCounters stats[STAGE_COUNT];
+    int available = counters_collect(stats);
+    if (opts->perf == TIMINGS_JSON)
+        display_stage_counters_json(stats, available);
+    else
+        display_stage_counters(stats, available);
+}
+
+// Grava a linha do tempo de --trace, após o término das threads
+static void write_trace(const Options *opts, RunSummary *summary)
+{
+    if (!opts->trace || trace_write(opts->trace))
+        return;
+    fprintf(stderr, "Erro ao gravar o trace %s\n", opts->trace);
+    summary->status = EXIT_ERROR;
+}
+
+int main(int argc, char **argv)
+{
+    Options opts;
+    int parsed = parse_options(argc, argv, &opts);
+    if (parsed <= 0)
+        return parsed < 0 ? EXIT_OK : EXIT_ERROR;
+
+    // Com --stats json a saída padrão fica reservada ao resumo
+    if (opts.stats_format == STATS_JSON)
+        set_report_stream(stderr);
+    if (opts.timings != TIMINGS_NONE)
+        timing_enable();
+    if (opts.lock_stats != TIMINGS_NONE)
+        lock_stats_enable();
+    if (opts.perf != TIMINGS_NONE)
+        counters_enable();
+    // As etapas da linha do tempo vêm da mesma medição de --timings
+    if (opts.trace)
+    {
+        timing_enable();
+        trace_enable();
+    }
+
+    /*
+     * MODO DAEMON
+     *
+     * Os pedidos chegam pelo socket e são atendidos pelo pool da libbulkedit
+     */
+    if (opts.daemon_socket)
+    {
+        int threads = opts.threads > 0 ? opts.threads : 0;
+        if (!run_daemon(opts.daemon_socket, threads))
+        {
+            fprintf(stderr, "Erro ao abrir o socket %s\n", opts.daemon_socket);
+            return EXIT_ERROR;
+        }
+        return EXIT_OK;
+    }
+
+    // Extração de um contêiner gerado com --pack
+    if (opts.unpack)
+    {
+        int failed;
+        int extracted = pack_extract(opts.unpack, opts.output_dir, &failed);
+        if (extracted < 0)
+        {
+            fprintf(stderr, "Contêiner inválido ou incompleto: %s\n", opts.unpack);
+            return EXIT_ERROR;
+        }
+        display_unpacked(extracted, failed, opts.output_dir);
+        return failed > 0 ? EXIT_PARTIAL : EXIT_OK;
+    }
+
+    /*
+     * MODO FLUXO
+     *
+     * Uma origem lida em sequência (stdin, tar ou diretório) e um destino
+     * (stdout, tar ou diretório), com o pool da libbulkedit entre eles. Com
+     * --stream a saída padrão fica reservada às imagens: relatórios e resumo
+     * vão para stderr
+     */
+    if (opts.stream || opts.tar_input || opts.tar_output)
+    {
+        RunSummary summary;
+        summary.status = run_stream_mode(&opts, &summary);
+        if (opts.stats_format == STATS_TEXT && summary.threads > 0) // Sem estatísticas se a origem ou o destino não abriram
+            display_final_statistics(&summary);
+        report_timings(&opts);
+        report_counters(&opts);
+        write_trace(&opts, &summary);
+        if (opts.stats_format == STATS_JSON)
+            display_summary_json(opts.stream ? stderr : stdout, &summary);
+        return summary.status;
+    }
+
+    // Nos modos lista e jobs não há diretório de entrada
+    char *input_dir = opts.file_list || opts.job_file ? NULL
+                      : opts.input_dir ? strdup(opts.input_dir)
+                                       : get_input_directory();
+    if (opts.input_dir)
+    {
+        DIR *dir = opendir(input_dir);
+        if (!dir)
+        {
+            fprintf(stderr, "Diretório não encontrado: %s\n", input_dir);
+            free(input_dir);
+            return EXIT_ERROR;
+        }
+        closedir(dir);
+    }
+    int num_threads = opts.threads != THREADS_ASK ? opts.threads : get_thread_count(available_cpus());
 
-    process_directory_parallel(input_dir, num_threads);
+    RunSummary summary;
+    process_directory_parallel(input_dir, num_threads, &opts, &summary);
+    report_timings(&opts);
+    report_counters(&opts);
+    report_lock_stats(&opts);
+    write_trace(&opts, &summary);
+    if (opts.stats_format == STATS_JSON)
+        display_summary_json(stdout, &summary);
 
     free(input_dir);
-    return 0;
+    return summary.status;
 }
\ No newline at end of file
@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include "manifest.h"
+#include "file_utils.h"
+
+#define MANIFEST_HEADER "# bulkedit manifest v1"
+
+static int compare_entries(const void *a, const void *b)
+{
+    const ManifestEntry *ea = a;
+    const ManifestEntry *eb = b;
+    return strcmp(ea->name, eb->name);
+}
+
+static const ManifestEntry *manifest_find(const Manifest *manifest, const char *name)
+{
+    if (manifest->count == 0)
+        return NULL;
+    ManifestEntry key = {.name = (char *)name};
+    return bsearch(&key, manifest->entries, manifest->count, sizeof(ManifestEntry), compare_entries);
+}
+
+static int64_t stat_mtime_ns(const struct stat *st)
+{
+    return (int64_t)st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+}
+
+/**
+ * @brief Chave da transformação registrada no manifesto
+ *
+ * Inclui a qualidade JPEG junto aos filtros ("grayscale,invert:q90"): uma
+ * execução com outra qualidade gera saídas diferentes e não deve pular as
+ * imagens já processadas.
+ *
+ * @param transform Transformação (qualidade da saída)
+ * @param filter Nome dos filtros, como informado
+ * @param chain Recebe a chave
+ * @param size Tamanho de `chain`
+ */
+void manifest_chain(const Transform *transform, const char *filter, char *chain, size_t size)
+{
+    snprintf(chain, size, "%s:q%d", filter, transform->quality);
+}
+
+int manifest_add(Manifest *manifest, const char *name, int64_t size, int64_t mtime_ns,
+                 uint64_t hash, int has_hash, const char *chain)
+{
+    // Nomes com quebra de linha não podem ser representados no formato texto
+    if (strchr(name, '\n') || strchr(chain, ' ') || strchr(chain, '\n'))
+        return 0;
+
+    if (manifest->count == manifest->capacity)
+    {
+        int capacity = manifest->capacity ? manifest->capacity * 2 : 64;
+        ManifestEntry *entries = realloc(manifest->entries, capacity * sizeof(ManifestEntry));
+        if (!entries)
+            return 0;
+        manifest->entries = entries;
+        manifest->capacity = capacity;
+    }
+
+    ManifestEntry *entry = &manifest->entries[manifest->count];
+    entry->name = strdup(name);
+    entry->chain = strdup(chain);
+    if (!entry->name || !entry->chain)
+    {
+        free(entry->name);
+        free(entry->chain);
+        return 0;
+    }
+    entry->size = size;
+    entry->mtime_ns = mtime_ns;
+    entry->hash = hash;
+    entry->has_hash = has_hash;
+    manifest->count++;
+    return 1;
+}
+
+/**
+ * @brief Carrega o manifesto do diretório de saída
+ *
+ * Cada linha tem o formato: <tamanho> <mtime_ns> <hash|-> <filtros:qualidade> <nome>
+ *
+ * @param manifest Manifesto a preencher (vazio se o arquivo não existir)
+ * @param output_dir Diretório de saída
+ * @return 1 se sucesso, 0 se falha de memória
+ */
+int manifest_load(Manifest *manifest, const char *output_dir)
+{
+    memset(manifest, 0, sizeof(*manifest));
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", output_dir, MANIFEST_FILE);
+    FILE *file = fopen(path, "r");
+    if (!file)
+        return 1;
+
+    char *line = NULL;
+    size_t line_cap = 0;
+    ssize_t len;
+    int ok = 1;
+    while ((len = getline(&line, &line_cap, file)) > 0)
+    {
+        if (line[len - 1] == '\n')
+            line[--len] = 0;
+        if (line[0] == '#' || len == 0)
+            continue;
+
+        int64_t size, mtime_ns;
+        char hash_text[17], chain[MANIFEST_CHAIN_SIZE];
+        int name_offset = 0;
+        if (sscanf(line, "%" SCNd64 " %" SCNd64 " %16s %127s %n",
+                   &size, &mtime_ns, hash_text, chain, &name_offset) != 4 || name_offset == 0)
+            continue;
+
+        int has_hash = strcmp(hash_text, "-") != 0;
+        uint64_t hash = has_hash ? strtoull(hash_text, NULL, 16) : 0;
+        if (!manifest_add(manifest, line + name_offset, size, mtime_ns, hash, has_hash, chain))
+        {
+            ok = 0;
+            break;
+        }
+    }
+    free(line);
+    fclose(file);
+
+    qsort(manifest->entries, manifest->count, sizeof(ManifestEntry), compare_entries);
+    return ok;
+}
+
+/**
+ * @brief Grava o manifesto de forma atômica (arquivo temporário + rename)
+ *
+ * @return 1 se sucesso, 0 se falha
+ */
+int manifest_save(const Manifest *manifest, const char *output_dir)
+{
+    char path[1024], tmp_path[1040];
+    snprintf(path, sizeof(path), "%s/%s", output_dir, MANIFEST_FILE);
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    FILE *file = fopen(tmp_path, "w");
+    if (!file)
+        return 0;
+
+    fprintf(file, "%s\n", MANIFEST_HEADER);
+    for (int i = 0; i < manifest->count; i++)
+    {
+        const ManifestEntry *entry = &manifest->entries[i];
+        char hash_text[17] = "-";
+        if (entry->has_hash)
+            snprintf(hash_text, sizeof(hash_text), "%016" PRIx64, entry->hash);
+        fprintf(file, "%" PRId64 " %" PRId64 " %s %s %s\n",
+                entry->size, entry->mtime_ns, hash_text, entry->chain, entry->name);
+    }
+
+    int ok = ferror(file) == 0;
+    ok &= fclose(file) == 0;
+    if (!ok || rename(tmp_path, path) != 0)
+    {
+        remove(tmp_path);
+        return 0;
+    }
+    return 1;
+}
+
+void manifest_free(Manifest *manifest)
+{
+    for (int i = 0; i < manifest->count; i++)
+    {
+        free(manifest->entries[i].name);
+        free(manifest->entries[i].chain);
+    }
+    free(manifest->entries);
+    memset(manifest, 0, sizeof(*manifest));
+}
+
+/**
+ * @brief Remove da lista as imagens cuja saída já está atualizada
+ *
+ * Uma saída é considerada atualizada quando o manifesto anterior registra a
+ * mesma chave (filtros e qualidade), o arquivo de saída existe e a entrada tem o mesmo
+ * tamanho e data de modificação. Com use_hash, uma data diferente é aceita se
+ * o hash do conteúdo for igual (ex.: arquivo copiado novamente).
+ *
+ * As entradas atualizadas são copiadas para o novo manifesto; as demais
+ * permanecem em paths (compactado) com tamanho, data e hash preenchidos.
+ *
+ * @return Quantidade de imagens que ainda precisam ser processadas
+ */
+int manifest_select_pending(const Manifest *previous, Manifest *next, const PathTable *table,
+                            ImagePath *paths, int count, const char *chain, int use_hash)
+{
+    char input_path[PATH_MAX], output_path[PATH_MAX];
+    int pending = 0;
+    for (int i = 0; i < count; i++)
+    {
+        ImagePath *path = &paths[i];
+        const char *name = path_table_name(table, path->name);
+
+        struct stat st;
+        if (!image_paths(table, path, input_path, output_path, sizeof(input_path)) ||
+            stat(input_path, &st) != 0)
+        {
+            // Deixa a thread trabalhadora reportar a falha de leitura
+            paths[pending++] = *path;
+            continue;
+        }
+        path->size = st.st_size;
+        path->mtime_ns = stat_mtime_ns(&st);
+        path->has_hash = 0;
+
+        const ManifestEntry *entry = manifest_find(previous, name);
+        int up_to_date = 0;
+        if (entry && strcmp(entry->chain, chain) == 0 && entry->size == path->size &&
+            stat(output_path, &st) == 0)
+        {
+            if (entry->mtime_ns == path->mtime_ns)
+            {
+                up_to_date = 1;
+                path->hash = entry->hash;
+                path->has_hash = entry->has_hash;
+            }
+            else if (use_hash && entry->has_hash && hash_file(input_path, &path->hash))
+            {
+                path->has_hash = 1;
+                up_to_date = path->hash == entry->hash;
+            }
+        }
+
+        if (use_hash && !path->has_hash)
+            path->has_hash = hash_file(input_path, &path->hash);
+
+        if (up_to_date)
+            manifest_add(next, name, path->size, path->mtime_ns, path->hash, path->has_hash, chain);
+        else
+            paths[pending++] = *path;
+    }
+    return pending;
+}
+
+/*
+ * Acrescenta ao manifesto as imagens gravadas com sucesso nesta execução
+ */
+void manifest_record_done(Manifest *next, const PathTable *table, const ImagePath *paths, int count,
+                          const char *chain)
+{
+    for (int i = 0; i < count; i++)
+    {
+        const ImagePath *path = &paths[i];
+        if (path->done)
+            manifest_add(next, path_table_name(table, path->name), path->size, path->mtime_ns,
+                         path->hash, path->has_hash, chain);
+    }
+}
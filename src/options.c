@@ -0,0 +1,480 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "options.h"
+#include "img_editing.h"
+#include "affinity.h"
+
+#define DEFAULT_QUEUE_SIZE 256
+#define DEFAULT_DEBOUNCE_MS 50
+
+enum
+{
+    OPT_QUEUE_SIZE = 256,
+    OPT_DEBOUNCE,
+    OPT_ORDER,
+    OPT_FILES,
+    OPT_AFFINITY,
+    OPT_IO_THREADS,
+    OPT_INPUT,
+    OPT_STATS,
+    OPT_JOBS,
+    OPT_DAEMON,
+    OPT_STREAM,
+    OPT_UNORDERED,
+    OPT_TAR_IN,
+    OPT_TAR_OUT,
+    OPT_PACK,
+    OPT_UNPACK,
+    OPT_TIMINGS,
+    OPT_LOCK_STATS,
+    OPT_TRACE,
+    OPT_PERF,
+};
+
+void print_usage(const char *program)
+{
+    printf("Uso: %s [opções]\n\n", program);
+    printf("      --input DIR     Diretório de entrada; nada é perguntado (requer --filter,\n");
+    printf("                      threads 'cpus' por padrão)\n");
+    printf("  -o, --output DIR    Diretório de saída (padrão <entrada>_<filtro>)\n");
+    printf("      --tar-in ARQUIVO Lê as imagens de um tar, sem extraí-lo (requer --filter)\n");
+    printf("      --tar-out ARQUIVO Grava as imagens geradas em um tar, na ordem da entrada\n");
+    printf("      --pack ARQUIVO  Grava as imagens geradas em um único arquivo de dados com índice\n");
+    printf("                      (ARQUIVO.idx), em vez de um arquivo por imagem (requer --input)\n");
+    printf("      --unpack ARQUIVO Extrai as imagens de um contêiner de --pack para --output\n");
+    printf("      --jobs ARQUIVO  Executa os jobs do arquivo (linhas 'input=DIR filter=F [output=DIR]\n");
+    printf("                      [priority=N] [quality=N]') em um único pool, sem perguntar\n");
+    printf("  -i, --incremental   Processa apenas imagens novas ou alteradas desde a última execução\n");
+    printf("  -H, --hash          Com --incremental, compara também o hash do conteúdo\n");
+    printf("  -d, --dedup         Processa uma vez entradas idênticas e liga as saídas das cópias\n");
+    printf("      --order ORDEM   Ordem da fila: 'largest' (maiores primeiro, padrão) ou 'dir'\n");
+    printf("  -w, --watch         Processa continuamente as imagens que chegam no diretório\n");
+    printf("      --queue-size N  Máximo de imagens aguardando no modo contínuo ou em andamento\n");
+    printf("                      no modo fluxo (padrão %d)\n",
+           DEFAULT_QUEUE_SIZE);
+    printf("      --debounce MS   Espera após a última notificação de um arquivo (padrão %d)\n",
+           DEFAULT_DEBOUNCE_MS);
+    printf("      --files LISTA   Processa os caminhos listados em LISTA ('-' para stdin),\n");
+    printf("                      um por linha, opcionalmente seguidos de TAB e caminho de saída\n");
+    printf("  -0, --null          Registros da lista separados por NUL em vez de quebra de linha\n");
+    printf("                      (cada registro é só a entrada, sem caminho de saída)\n");
+    printf("  -t, --threads N     Número de threads (sem perguntar); 'auto' ajusta pela vazão,\n");
+    printf("                      'cpus' usa uma por CPU disponível (respeitando a cota do cgroup)\n");
+    printf("  -f, --filter NOMES  Filtro a aplicar (sem perguntar); vários separados por vírgula\n");
+    printf("                      são aplicados em ordem, ex.: grayscale,invert\n");
+    printf("  -q, --quality N     Qualidade JPEG da saída, de 1 a 100 (padrão %d)\n", DEFAULT_QUALITY);
+    printf("      --stream FORMATO Lê imagens da entrada padrão e grava o resultado na saída\n");
+    printf("                      padrão: 'len' (tamanho em 4 bytes big-endian + imagem) ou\n");
+    printf("                      'tar' (requer --filter)\n");
+    printf("      --unordered     No fluxo ou com tar, grava cada imagem assim que fica pronta,\n");
+    printf("                      sem manter a ordem da entrada\n");
+    printf("      --daemon SOCKET Atende pedidos por um socket Unix, mantendo o pool ativo\n");
+    printf("      --stats FORMATO Estatísticas finais: 'text' (padrão) ou 'json' (uma linha na\n");
+    printf("                      saída padrão; os demais relatórios vão para stderr)\n");
+    printf("      --timings FORMATO Mede leitura, decodificação, filtros, codificação, gravação e\n");
+    printf("                      espera na fila de cada imagem: 'text' (percentis por etapa)\n");
+    printf("                      ou 'json' (uma linha junto aos relatórios)\n");
+    printf("      --lock-stats FORMATO Conta, por thread, travas e disputas do mutex da fila,\n");
+    printf("                      tempo de espera e despertares (espúrios inclusive): 'text' ou 'json'\n");
+    printf("      --trace ARQUIVO Grava a linha do tempo (formato trace-event do Chrome/Perfetto)\n");
+    printf("                      com uma trilha por thread e as etapas de cada imagem\n");
+    printf("      --perf FORMATO  Lê ciclos, instruções, faltas de LLC e desvios errados\n");
+    printf("                      (perf_event_open) na decodificação, nos filtros e na\n");
+    printf("                      codificação: 'text' (tabela por etapa) ou 'json'\n");
+    printf("      --affinity MODO Fixa as threads em CPUs: 'compact' (um nó NUMA por vez),\n");
+    printf("                      'scatter' (alterna entre nós) ou lista como '0-7,16-23'\n");
+    printf("      --io-threads N  Separa N threads de leitura/gravação das threads de processamento\n");
+    printf("                      (que passam a ser uma por CPU por padrão)\n");
+    printf("  -h, --help          Mostra esta ajuda\n\n");
+    printf("Código de saída: 0 sucesso, 1 erro de uso ou de execução, 2 alguma imagem ou job falhou\n");
+}
+
+/**
+ * @brief Lê as opções da linha de comando
+ *
+ * @param argc Quantidade de argumentos
+ * @param argv Argumentos
+ * @param opts Estrutura preenchida com as opções
+ * @return 1 se sucesso, 0 se houver opção inválida, -1 se a ajuda foi exibida
+ */
+int parse_options(int argc, char **argv, Options *opts)
+{
+    static const struct option long_options[] = {
+        {"incremental", no_argument, NULL, 'i'},
+        {"hash", no_argument, NULL, 'H'},
+        {"dedup", no_argument, NULL, 'd'},
+        {"order", required_argument, NULL, OPT_ORDER},
+        {"watch", no_argument, NULL, 'w'},
+        {"queue-size", required_argument, NULL, OPT_QUEUE_SIZE},
+        {"debounce", required_argument, NULL, OPT_DEBOUNCE},
+        {"files", required_argument, NULL, OPT_FILES},
+        {"null", no_argument, NULL, '0'},
+        {"threads", required_argument, NULL, 't'},
+        {"filter", required_argument, NULL, 'f'},
+        {"affinity", required_argument, NULL, OPT_AFFINITY},
+        {"io-threads", required_argument, NULL, OPT_IO_THREADS},
+        {"input", required_argument, NULL, OPT_INPUT},
+        {"output", required_argument, NULL, 'o'},
+        {"quality", required_argument, NULL, 'q'},
+        {"stats", required_argument, NULL, OPT_STATS},
+        {"timings", required_argument, NULL, OPT_TIMINGS},
+        {"lock-stats", required_argument, NULL, OPT_LOCK_STATS},
+        {"trace", required_argument, NULL, OPT_TRACE},
+        {"perf", required_argument, NULL, OPT_PERF},
+        {"jobs", required_argument, NULL, OPT_JOBS},
+        {"daemon", required_argument, NULL, OPT_DAEMON},
+        {"stream", required_argument, NULL, OPT_STREAM},
+        {"unordered", no_argument, NULL, OPT_UNORDERED},
+        {"tar-in", required_argument, NULL, OPT_TAR_IN},
+        {"tar-out", required_argument, NULL, OPT_TAR_OUT},
+        {"pack", required_argument, NULL, OPT_PACK},
+        {"unpack", required_argument, NULL, OPT_UNPACK},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}};
+
+    memset(opts, 0, sizeof(*opts));
+    opts->order = ORDER_LARGEST_FIRST;
+    opts->queue_size = DEFAULT_QUEUE_SIZE;
+    opts->debounce_ms = DEFAULT_DEBOUNCE_MS;
+    opts->list_delimiter = '\n';
+    opts->threads = THREADS_ASK;
+    opts->quality = DEFAULT_QUALITY;
+    opts->stats_format = STATS_TEXT;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "iHdw0t:f:o:q:h", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'i':
+            opts->incremental = 1;
+            break;
+        case 'H':
+            opts->content_hash = 1;
+            break;
+        case 'd':
+            opts->dedup = 1;
+            break;
+        case OPT_ORDER:
+            if (strcmp(optarg, "largest") == 0)
+                opts->order = ORDER_LARGEST_FIRST;
+            else if (strcmp(optarg, "dir") == 0)
+                opts->order = ORDER_DIRECTORY;
+            else
+            {
+                fprintf(stderr, "Ordem inválida: %s\n", optarg);
+                return 0;
+            }
+            break;
+        case 'w':
+            opts->watch = 1;
+            break;
+        case OPT_QUEUE_SIZE:
+            opts->queue_size = atoi(optarg);
+            if (opts->queue_size <= 0)
+            {
+                fprintf(stderr, "--queue-size deve ser positivo\n");
+                return 0;
+            }
+            break;
+        case OPT_DEBOUNCE:
+            opts->debounce_ms = atoi(optarg);
+            if (opts->debounce_ms < 0)
+            {
+                fprintf(stderr, "--debounce não pode ser negativo\n");
+                return 0;
+            }
+            break;
+        case OPT_FILES:
+            opts->file_list = optarg;
+            break;
+        case '0':
+            opts->list_delimiter = '\0';
+            break;
+        case 't':
+            if (strcmp(optarg, "auto") == 0)
+                opts->threads = THREADS_AUTO;
+            else if (strcmp(optarg, "cpus") == 0)
+                opts->threads = THREADS_DEFAULT;
+            else if ((opts->threads = atoi(optarg)) <= 0)
+            {
+                fprintf(stderr, "--threads deve ser positivo\n");
+                return 0;
+            }
+            break;
+        case 'f':
+            opts->filter = optarg;
+            break;
+        case OPT_AFFINITY:
+            opts->affinity = optarg;
+            break;
+        case OPT_IO_THREADS:
+            if ((opts->io_threads = atoi(optarg)) <= 0)
+            {
+                fprintf(stderr, "--io-threads deve ser positivo\n");
+                return 0;
+            }
+            break;
+        case OPT_INPUT:
+            opts->input_dir = optarg;
+            break;
+        case 'o':
+            opts->output_dir = optarg;
+            break;
+        case 'q':
+            opts->quality = atoi(optarg);
+            if (opts->quality < 1 || opts->quality > 100)
+            {
+                fprintf(stderr, "--quality deve estar entre 1 e 100\n");
+                return 0;
+            }
+            break;
+        case OPT_DAEMON:
+            opts->daemon_socket = optarg;
+            break;
+        case OPT_STREAM:
+            if (strcmp(optarg, "len") == 0)
+                opts->stream = STREAM_LENGTH;
+            else if (strcmp(optarg, "tar") == 0)
+                opts->stream = STREAM_TAR;
+            else
+            {
+                fprintf(stderr, "Formato de fluxo inválido: %s\n", optarg);
+                return 0;
+            }
+            break;
+        case OPT_UNORDERED:
+            opts->unordered = 1;
+            break;
+        case OPT_TAR_IN:
+            opts->tar_input = optarg;
+            break;
+        case OPT_TAR_OUT:
+            opts->tar_output = optarg;
+            break;
+        case OPT_PACK:
+            opts->pack = optarg;
+            break;
+        case OPT_UNPACK:
+            opts->unpack = optarg;
+            break;
+        case OPT_JOBS:
+            opts->job_file = optarg;
+            break;
+        case OPT_STATS:
+            if (strcmp(optarg, "text") == 0)
+                opts->stats_format = STATS_TEXT;
+            else if (strcmp(optarg, "json") == 0)
+                opts->stats_format = STATS_JSON;
+            else
+            {
+                fprintf(stderr, "Formato de estatísticas inválido: %s\n", optarg);
+                return 0;
+            }
+            break;
+        case OPT_TIMINGS:
+            if (strcmp(optarg, "text") == 0)
+                opts->timings = TIMINGS_TEXT;
+            else if (strcmp(optarg, "json") == 0)
+                opts->timings = TIMINGS_JSON;
+            else
+            {
+                fprintf(stderr, "Formato de tempos inválido: %s\n", optarg);
+                return 0;
+            }
+            break;
+        case OPT_LOCK_STATS:
+            if (strcmp(optarg, "text") == 0)
+                opts->lock_stats = TIMINGS_TEXT;
+            else if (strcmp(optarg, "json") == 0)
+                opts->lock_stats = TIMINGS_JSON;
+            else
+            {
+                fprintf(stderr, "Formato de disputa inválido: %s\n", optarg);
+                return 0;
+            }
+            break;
+        case OPT_TRACE:
+            opts->trace = optarg;
+            break;
+        case OPT_PERF:
+            if (strcmp(optarg, "text") == 0)
+                opts->perf = TIMINGS_TEXT;
+            else if (strcmp(optarg, "json") == 0)
+                opts->perf = TIMINGS_JSON;
+            else
+            {
+                fprintf(stderr, "Formato de contadores inválido: %s\n", optarg);
+                return 0;
+            }
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return -1;
+        default:
+            print_usage(argv[0]);
+            return 0;
+        }
+    }
+
+    if (opts->content_hash && !opts->incremental)
+    {
+        fprintf(stderr, "--hash requer --incremental\n");
+        return 0;
+    }
+    if ((opts->watch || opts->file_list) && (opts->incremental || opts->dedup))
+    {
+        fprintf(stderr, "--watch e --files não podem ser combinados com --incremental ou --dedup\n");
+        return 0;
+    }
+    if (opts->watch && opts->file_list)
+    {
+        fprintf(stderr, "--watch não pode ser combinado com --files\n");
+        return 0;
+    }
+    if (optind < argc)
+    {
+        fprintf(stderr, "Argumento inesperado: %s\n", argv[optind]);
+        return 0;
+    }
+    if (opts->filter)
+    {
+        Transform transform;
+        if (!parse_transform(opts->filter, opts->quality, &transform))
+        {
+            fprintf(stderr, "Filtro inválido: %s\n", opts->filter);
+            return 0;
+        }
+    }
+    if (opts->unpack)
+    {
+        if (!opts->output_dir || opts->input_dir || opts->file_list || opts->watch || opts->job_file ||
+            opts->daemon_socket || opts->stream || opts->tar_input || opts->tar_output || opts->pack ||
+            opts->filter)
+        {
+            fprintf(stderr, "--unpack requer --output e não pode ser combinado com outros modos\n");
+            return 0;
+        }
+        return 1;
+    }
+    if (opts->pack)
+    {
+        if (!opts->input_dir || opts->output_dir || opts->incremental || opts->dedup || opts->watch ||
+            opts->file_list || opts->job_file || opts->stream || opts->tar_input || opts->tar_output)
+        {
+            fprintf(stderr, "--pack requer --input e não pode ser combinado com --output, "
+                            "--incremental, --dedup, --watch, --files, --jobs ou tar\n");
+            return 0;
+        }
+    }
+    if (opts->daemon_socket)
+    {
+        if (opts->input_dir || opts->file_list || opts->watch || opts->job_file || opts->incremental ||
+            opts->dedup || opts->filter || opts->output_dir || opts->io_threads || opts->affinity ||
+            opts->lock_stats || opts->trace || opts->perf)
+        {
+            fprintf(stderr, "--daemon só pode ser combinado com --threads e --stats\n");
+            return 0;
+        }
+        if (opts->threads == THREADS_ASK)
+            opts->threads = THREADS_DEFAULT;
+    }
+    if (opts->unordered && !opts->stream && !opts->tar_input && !opts->tar_output)
+    {
+        fprintf(stderr, "--unordered requer --stream, --tar-in ou --tar-out\n");
+        return 0;
+    }
+    if (opts->stream && (opts->input_dir || opts->output_dir || opts->tar_input || opts->tar_output))
+    {
+        fprintf(stderr, "--stream usa a entrada e a saída padrão (sem --input, --output, --tar-in "
+                        "ou --tar-out)\n");
+        return 0;
+    }
+    if (opts->tar_input && opts->input_dir)
+    {
+        fprintf(stderr, "--tar-in não pode ser combinado com --input\n");
+        return 0;
+    }
+    if (opts->tar_output && (opts->output_dir || (!opts->input_dir && !opts->tar_input)))
+    {
+        fprintf(stderr, "--tar-out requer --input ou --tar-in e não pode ser combinado com --output\n");
+        return 0;
+    }
+    // Modos de fluxo: uma origem lida em sequência e um destino, com o pool da libbulkedit
+    if (opts->stream || opts->tar_input || opts->tar_output)
+    {
+        if (opts->file_list || opts->watch || opts->job_file || opts->daemon_socket ||
+            opts->incremental || opts->dedup || opts->io_threads || opts->affinity || opts->lock_stats)
+        {
+            fprintf(stderr, "--stream, --tar-in e --tar-out não podem ser combinados com --files, "
+                            "--watch, --jobs, --daemon, --incremental, --dedup, --io-threads, "
+                            "--affinity ou --lock-stats\n");
+            return 0;
+        }
+        if (!opts->filter || opts->threads == THREADS_AUTO)
+        {
+            fprintf(stderr, "--stream, --tar-in e --tar-out requerem --filter e não aceitam "
+                            "--threads auto\n");
+            return 0;
+        }
+        if (opts->threads == THREADS_ASK)
+            opts->threads = THREADS_DEFAULT;
+    }
+    if (opts->job_file)
+    {
+        if (opts->input_dir || opts->file_list || opts->watch || opts->dedup || opts->filter ||
+            opts->output_dir)
+        {
+            fprintf(stderr, "--jobs não pode ser combinado com --input, --files, --watch, --dedup, "
+                            "--filter ou --output\n");
+            return 0;
+        }
+        if (opts->threads == THREADS_ASK)
+            opts->threads = THREADS_DEFAULT;
+    }
+    if (opts->input_dir && opts->file_list)
+    {
+        fprintf(stderr, "--input não pode ser combinado com --files\n");
+        return 0;
+    }
+    if (opts->output_dir && !opts->input_dir && !opts->tar_input)
+    {
+        fprintf(stderr, "--output requer --input ou --tar-in\n");
+        return 0;
+    }
+    // Sem perguntas: o filtro é obrigatório e o número de threads tem padrão
+    if (opts->input_dir)
+    {
+        if (!opts->filter)
+        {
+            fprintf(stderr, "--input requer --filter\n");
+            return 0;
+        }
+        if (opts->threads == THREADS_ASK)
+            opts->threads = THREADS_DEFAULT;
+    }
+    if (opts->affinity)
+    {
+        int cpu;
+        if (!affinity_plan(opts->affinity, 1, &cpu))
+        {
+            fprintf(stderr, "--affinity inválida ou sem CPUs permitidas ao processo: %s\n",
+                    opts->affinity);
+            return 0;
+        }
+    }
+    if (opts->io_threads && opts->threads == THREADS_AUTO)
+    {
+        fprintf(stderr, "--io-threads não pode ser combinado com --threads auto\n");
+        return 0;
+    }
+    if (opts->file_list && strcmp(opts->file_list, "-") == 0 && (opts->threads == THREADS_ASK || !opts->filter))
+    {
+        fprintf(stderr, "--files - requer --threads e --filter (stdin é usado pela lista)\n");
+        return 0;
+    }
+    return 1;
+}
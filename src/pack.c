@@ -0,0 +1,211 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include "pack.h"
+#include "file_utils.h"
+
+// Identifica o índice e a versão do formato
+#define PACK_MAGIC "BEPACK01"
+
+/*
+ * Cabeçalho do índice, gravado no primeiro registro ao final da execução
+ */
+typedef struct
+{
+    char magic[8];
+    uint32_t record_size;
+    uint32_t records;   // Registros após o cabeçalho (0 = gravação não concluída)
+    uint64_t data_size; // Bytes usados no arquivo de dados
+} PackHeader;
+
+_Static_assert(sizeof(PackRecord) == PACK_RECORD_SIZE, "registro do índice com tamanho fixo");
+
+static int pwrite_all(int fd, const void *data, size_t size, uint64_t offset)
+{
+    const char *p = data;
+    while (size > 0)
+    {
+        ssize_t n = pwrite(fd, p, size, (off_t)offset);
+        if (n <= 0)
+            return 0;
+        p += n;
+        size -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+    return 1;
+}
+
+static int pread_all(int fd, void *data, size_t size, uint64_t offset)
+{
+    char *p = data;
+    while (size > 0)
+    {
+        ssize_t n = pread(fd, p, size, (off_t)offset);
+        if (n <= 0)
+            return 0;
+        p += n;
+        size -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+    return 1;
+}
+
+static void index_path(char *path, size_t size, const char *data_path)
+{
+    snprintf(path, size, "%s.idx", data_path);
+}
+
+/**
+ * @brief Cria o contêiner: arquivo de dados `path` e índice `path`.idx
+ *
+ * O cabeçalho fica zerado até pack_finish, de modo que um contêiner de
+ * uma execução interrompida é reconhecido como incompleto
+ *
+ * @return 1 se sucesso, 0 se falha
+ */
+int pack_create(Pack *pack, const char *path)
+{
+    char idx[PATH_MAX];
+    index_path(idx, sizeof(idx), path);
+    pack->data_end = 0;
+    pack->data_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    pack->index_fd = open(idx, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (pack->data_fd < 0 || pack->index_fd < 0)
+    {
+        if (pack->data_fd >= 0)
+            close(pack->data_fd);
+        if (pack->index_fd >= 0)
+            close(pack->index_fd);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Guarda uma imagem; pode ser chamada por várias threads ao mesmo tempo
+ *
+ * @param record Posição do registro no índice (única por imagem)
+ * @param name Nome usado na extração (truncado em PACK_NAME_SIZE - 1 bytes)
+ * @return 1 se sucesso, 0 se falha de escrita
+ */
+int pack_append(Pack *pack, uint32_t record, const char *name, const unsigned char *data,
+                size_t size, int width, int height)
+{
+    if (size > UINT32_MAX)
+        return 0;
+
+    // Reserva atômica da região: as gravações de threads diferentes não se sobrepõem
+    uint64_t offset = __atomic_fetch_add(&pack->data_end, (uint64_t)size, __ATOMIC_RELAXED);
+    if (!pwrite_all(pack->data_fd, data, size, offset))
+        return 0;
+
+    PackRecord entry;
+    memset(&entry, 0, sizeof(entry));
+    snprintf(entry.name, sizeof(entry.name), "%s", name);
+    entry.offset = offset;
+    entry.length = (uint32_t)size;
+    entry.width = (uint32_t)width;
+    entry.height = (uint32_t)height;
+    return pwrite_all(pack->index_fd, &entry, sizeof(entry), ((uint64_t)record + 1) * PACK_RECORD_SIZE);
+}
+
+/**
+ * @brief Conclui o contêiner gravando o cabeçalho do índice e fecha os arquivos
+ *
+ * @param records Quantidade de registros (posições reservadas, com ou sem imagem)
+ * @return 1 se sucesso, 0 se falha
+ */
+int pack_finish(Pack *pack, uint32_t records)
+{
+    PackHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PACK_MAGIC, sizeof(header.magic));
+    header.record_size = PACK_RECORD_SIZE;
+    header.records = records;
+    header.data_size = pack->data_end;
+
+    // O índice cobre todos os registros, mesmo que os últimos não tenham imagem
+    int ok = ftruncate(pack->index_fd, ((off_t)records + 1) * PACK_RECORD_SIZE) == 0 &&
+             pwrite_all(pack->index_fd, &header, sizeof(header), 0);
+    ok = close(pack->data_fd) == 0 && ok;
+    ok = close(pack->index_fd) == 0 && ok;
+    return ok;
+}
+
+/**
+ * @brief Extrai as imagens de um contêiner para um diretório
+ *
+ * @param path Arquivo de dados (o índice é `path`.idx)
+ * @param output_dir Diretório de destino (criado se preciso)
+ * @param failed Imagens que não puderam ser gravadas
+ * @return Imagens extraídas, ou -1 se o contêiner é inválido ou incompleto
+ */
+int pack_extract(const char *path, const char *output_dir, int *failed)
+{
+    char idx[PATH_MAX];
+    index_path(idx, sizeof(idx), path);
+    *failed = 0;
+    int data_fd = open(path, O_RDONLY | O_CLOEXEC);
+    int index_fd = open(idx, O_RDONLY | O_CLOEXEC);
+
+    PackHeader header;
+    int extracted = -1;
+    if (data_fd >= 0 && index_fd >= 0 && pread_all(index_fd, &header, sizeof(header), 0) &&
+        memcmp(header.magic, PACK_MAGIC, sizeof(header.magic)) == 0 &&
+        header.record_size == PACK_RECORD_SIZE && make_dirs(output_dir))
+    {
+        extracted = 0;
+        unsigned char *buffer = NULL;
+        size_t capacity = 0;
+        for (uint32_t i = 0; i < header.records; i++)
+        {
+            PackRecord entry;
+            if (!pread_all(index_fd, &entry, sizeof(entry), ((uint64_t)i + 1) * PACK_RECORD_SIZE))
+            {
+                extracted = -1;
+                break;
+            }
+            entry.name[PACK_NAME_SIZE - 1] = 0;
+            if (!entry.name[0])
+                continue;
+
+            // Nomes vêm do contêiner: nada de subdiretórios fora do destino
+            char output_path[PATH_MAX];
+            if (strchr(entry.name, '/') || strcmp(entry.name, "..") == 0 ||
+                entry.offset > header.data_size || entry.length > header.data_size - entry.offset ||
+                snprintf(output_path, sizeof(output_path), "%s/%s", output_dir, entry.name) >=
+                    (int)sizeof(output_path))
+            {
+                (*failed)++;
+                continue;
+            }
+
+            if (entry.length > capacity)
+            {
+                unsigned char *grown = realloc(buffer, entry.length);
+                if (!grown)
+                {
+                    (*failed)++;
+                    continue;
+                }
+                buffer = grown;
+                capacity = entry.length;
+            }
+            if (pread_all(data_fd, buffer, entry.length, entry.offset) &&
+                write_file(output_path, buffer, entry.length))
+                extracted++;
+            else
+                (*failed)++;
+        }
+        free(buffer);
+    }
+    if (data_fd >= 0)
+        close(data_fd);
+    if (index_fd >= 0)
+        close(index_fd);
+    return extracted;
+}
@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "path_table.h"
+#include "file_utils.h"
+
+void path_table_init(PathTable *table)
+{
+    memset(table, 0, sizeof(*table));
+}
+
+void path_table_free(PathTable *table)
+{
+    for (uint32_t i = 0; i < table->dir_count; i++)
+        free(table->dirs[i]);
+    free(table->dirs);
+    free(table->dir_index);
+    free(table->names);
+    memset(table, 0, sizeof(*table));
+}
+
+/*
+ * Descarta os primeiros `count` bytes de nomes, movendo os demais para o
+ * início da arena (os deslocamentos deles diminuem de `count`); mantém os
+ * diretórios e a memória já reservada
+ */
+void path_table_drop_names(PathTable *table, size_t count)
+{
+    memmove(table->names, table->names + count, table->names_size - count);
+    table->names_size -= count;
+}
+
+static uint32_t dir_slot(const PathTable *table, const char *dir)
+{
+    uint32_t mask = table->dir_index_size - 1;
+    uint32_t slot = (uint32_t)hash_bytes(dir, strlen(dir), 0) & mask;
+    while (table->dir_index[slot] && strcmp(table->dirs[table->dir_index[slot] - 1], dir) != 0)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+static int grow_dirs(PathTable *table)
+{
+    uint32_t capacity = table->dir_capacity ? table->dir_capacity * 2 : 16;
+    char **dirs = realloc(table->dirs, capacity * sizeof(char *));
+    if (!dirs)
+        return 0;
+    table->dirs = dirs;
+
+    uint32_t index_size = capacity * 2;
+    uint32_t *index = calloc(index_size, sizeof(uint32_t));
+    if (!index)
+        return 0;
+    free(table->dir_index);
+    table->dir_index = index;
+    table->dir_index_size = index_size;
+    table->dir_capacity = capacity;
+
+    for (uint32_t i = 0; i < table->dir_count; i++)
+        table->dir_index[dir_slot(table, table->dirs[i])] = i + 1;
+    return 1;
+}
+
+/**
+ * @brief Obtém o índice de um diretório, inserindo-o se ainda não existir
+ *
+ * @return 1 se sucesso, 0 se falha de memória
+ */
+int path_table_add_dir(PathTable *table, const char *dir, uint32_t *index)
+{
+    if (table->dir_count == table->dir_capacity && !grow_dirs(table))
+        return 0;
+
+    uint32_t slot = dir_slot(table, dir);
+    if (!table->dir_index[slot])
+    {
+        char *copy = strdup(dir);
+        if (!copy)
+            return 0;
+        table->dirs[table->dir_count++] = copy;
+        table->dir_index[slot] = table->dir_count;
+    }
+    *index = table->dir_index[slot] - 1;
+    return 1;
+}
+
+/**
+ * @brief Copia um nome para a arena
+ *
+ * @param offset Deslocamento do nome na arena
+ * @return 1 se sucesso, 0 se falha de memória ou arena acima de 4 GB
+ */
+int path_table_add_name(PathTable *table, const char *name, uint32_t *offset)
+{
+    size_t len = strlen(name) + 1;
+    if (table->names_size + len > UINT32_MAX)
+        return 0;
+
+    if (table->names_size + len > table->names_capacity)
+    {
+        size_t capacity = table->names_capacity ? table->names_capacity : 64 * 1024;
+        while (capacity < table->names_size + len)
+            capacity *= 2;
+        char *names = realloc(table->names, capacity);
+        if (!names)
+            return 0;
+        table->names = names;
+        table->names_capacity = capacity;
+    }
+
+    memcpy(table->names + table->names_size, name, len);
+    *offset = (uint32_t)table->names_size;
+    table->names_size += len;
+    return 1;
+}
+
+/*
+ * Separa um caminho completo em diretório e nome e insere ambos
+ */
+int path_table_add_path(PathTable *table, const char *path, uint32_t *dir, uint32_t *name)
+{
+    const char *slash = strrchr(path, '/');
+    if (!slash)
+        return path_table_add_dir(table, ".", dir) && path_table_add_name(table, path, name);
+
+    size_t dir_len = slash == path ? 1 : (size_t)(slash - path);
+    char *dir_copy = strndup(path, dir_len);
+    if (!dir_copy)
+        return 0;
+    int ok = path_table_add_dir(table, dir_copy, dir) && path_table_add_name(table, slash + 1, name);
+    free(dir_copy);
+    return ok;
+}
+
+const char *path_table_dir(const PathTable *table, uint32_t index)
+{
+    return table->dirs[index];
+}
+
+const char *path_table_name(const PathTable *table, uint32_t offset)
+{
+    return table->names + offset;
+}
+
+/**
+ * @brief Monta o caminho completo <diretório>/<nome> no buffer informado
+ *
+ * @return 1 se sucesso, 0 se o caminho não cabe no buffer
+ */
+int path_table_join(const PathTable *table, uint32_t dir, uint32_t name, char *buffer, size_t size)
+{
+    const char *dir_text = table->dirs[dir];
+    int len = snprintf(buffer, size, "%s%s%s", dir_text,
+                       strcmp(dir_text, "/") == 0 ? "" : "/", table->names + name);
+    return len >= 0 && (size_t)len < size;
+}
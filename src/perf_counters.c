@@ -0,0 +1,186 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "perf_counters.h"
+
+/*
+ * Contadores de uma thread
+ *
+ * Cada thread abre os seus contadores (pid 0, qualquer CPU, só modo
+ * usuário) no primeiro uso. Os contadores são independentes, e não um
+ * grupo, para que a falta de um deles (comum em VMs) não desligue os
+ * demais. Como em timing.c, só a própria thread escreve nas somas, e os
+ * blocos ficam numa lista global lida depois que as threads terminam.
+ */
+typedef struct ThreadCounters
+{
+    int fds[COUNTER_COUNT];      // -1 se o contador não pôde ser aberto ou já foi fechado
+    int opened[COUNTER_COUNT];   // O contador foi aberto (continua valendo após fechá-lo)
+    uint64_t count[STAGE_COUNT];
+    int64_t pixels[STAGE_COUNT];
+    double value[STAGE_COUNT][COUNTER_COUNT];
+    struct ThreadCounters *next;
+} ThreadCounters;
+
+static int enabled = 0;
+static ThreadCounters *all_threads = NULL;
+static __thread ThreadCounters *local = NULL;
+static pthread_key_t close_key;
+static pthread_once_t close_once = PTHREAD_ONCE_INIT;
+
+static const struct
+{
+    uint32_t type;
+    uint64_t config;
+    const char *name;
+} counter_events[COUNTER_COUNT] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "llc_misses"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "branch_misses"},
+};
+
+// Ao fim da thread os contadores são fechados; as somas continuam na lista
+static void close_counters(void *arg)
+{
+    ThreadCounters *counters = arg;
+    for (int c = 0; c < COUNTER_COUNT; c++)
+    {
+        if (counters->fds[c] >= 0)
+            close(counters->fds[c]);
+        counters->fds[c] = -1;
+    }
+}
+
+static void create_close_key(void)
+{
+    pthread_key_create(&close_key, close_counters);
+}
+
+static int open_counter(Counter counter)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = counter_events[counter].type;
+    attr.config = counter_events[counter].config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+// Bloco da thread chamadora, com os contadores abertos no primeiro uso
+static ThreadCounters *thread_counters(void)
+{
+    if (!local)
+    {
+        local = calloc(1, sizeof(ThreadCounters));
+        if (!local)
+            return NULL;
+        for (int c = 0; c < COUNTER_COUNT; c++)
+        {
+            local->fds[c] = open_counter(c);
+            local->opened[c] = local->fds[c] >= 0;
+        }
+        pthread_once(&close_once, create_close_key);
+        pthread_setspecific(close_key, local);
+        local->next = __atomic_load_n(&all_threads, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&all_threads, &local->next, local, 0, __ATOMIC_RELEASE,
+                                            __ATOMIC_RELAXED))
+            ;
+    }
+    return local;
+}
+
+/**
+ * @brief Liga a leitura dos contadores; deve ser chamada antes de criar as threads
+ */
+void counters_enable(void)
+{
+    enabled = 1;
+}
+
+/**
+ * @brief Lê os contadores da thread chamadora
+ *
+ * Sem medição (ou sem contadores), a leitura fica zerada
+ */
+void counters_read(CounterSample *sample)
+{
+    memset(sample, 0, sizeof(*sample));
+    ThreadCounters *counters = enabled ? thread_counters() : NULL;
+    if (!counters)
+        return;
+    for (int c = 0; c < COUNTER_COUNT; c++)
+    {
+        uint64_t data[3];
+        if (counters->fds[c] >= 0 && read(counters->fds[c], data, sizeof(data)) == sizeof(data))
+        {
+            sample->value[c] = data[0];
+            sample->enabled[c] = data[1];
+            sample->running[c] = data[2];
+        }
+    }
+}
+
+/**
+ * @brief Soma à etapa a diferença entre duas leituras da mesma thread
+ *
+ * Se o kernel multiplexou o contador no intervalo, o valor é estimado pela
+ * fração do tempo em que ele realmente contou
+ *
+ * @param pixels Pixels da imagem medida
+ */
+void counters_record(Stage stage, const CounterSample *start, const CounterSample *end, int64_t pixels)
+{
+    ThreadCounters *counters = enabled ? local : NULL;
+    if (!counters)
+        return;
+    counters->count[stage]++;
+    counters->pixels[stage] += pixels;
+    for (int c = 0; c < COUNTER_COUNT; c++)
+    {
+        uint64_t running = end->running[c] - start->running[c];
+        if (running == 0)
+            continue;
+        double scale = (double)(end->enabled[c] - start->enabled[c]) / running;
+        counters->value[stage][c] += (end->value[c] - start->value[c]) * scale;
+    }
+}
+
+/**
+ * @brief Soma os contadores de todas as threads, por etapa
+ *
+ * Deve ser chamada depois que as threads medidas terminaram
+ *
+ * @return 1 se algum contador pôde ser aberto, 0 caso contrário
+ */
+int counters_collect(StageCounters stats[STAGE_COUNT])
+{
+    memset(stats, 0, STAGE_COUNT * sizeof(StageCounters));
+    int any = 0;
+    for (ThreadCounters *t = __atomic_load_n(&all_threads, __ATOMIC_ACQUIRE); t; t = t->next)
+    {
+        for (int s = 0; s < STAGE_COUNT; s++)
+        {
+            stats[s].count += t->count[s];
+            stats[s].pixels += t->pixels[s];
+            for (int c = 0; c < COUNTER_COUNT; c++)
+            {
+                stats[s].value[c] += t->value[s][c];
+                if (t->count[s] && t->opened[c])
+                    stats[s].available[c] = any = 1;
+            }
+        }
+    }
+    return any;
+}
+
+const char *counter_name(Counter counter)
+{
+    return counter_events[counter].name;
+}
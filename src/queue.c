@@ -0,0 +1,348 @@
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "queue.h"
+#include "lock_stats.h"
+
+void queue_init(Queue *queue)
+{
+    memset(queue, 0, sizeof(*queue));
+    queue->active_limit = INT_MAX;
+    // Inicializando objetos de sincronização
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->queue_cond, NULL);
+    pthread_cond_init(&queue->done_cond, NULL);
+    pthread_cond_init(&queue->space_cond, NULL);
+    pthread_cond_init(&queue->parked_cond, NULL);
+    path_table_init(&queue->table);
+}
+
+void queue_destroy(Queue *queue)
+{
+    // Destruindo objetos de sincronização
+    pthread_mutex_destroy(&queue->mutex);
+    pthread_cond_destroy(&queue->queue_cond);
+    pthread_cond_destroy(&queue->done_cond);
+    pthread_cond_destroy(&queue->space_cond);
+    pthread_cond_destroy(&queue->parked_cond);
+    free(queue->paths);
+    queue->paths = NULL;
+    path_table_free(&queue->table);
+}
+
+/**
+ * @brief Monta os caminhos completos de entrada e saída de uma imagem
+ *
+ * @return 1 se sucesso, 0 se algum caminho não cabe em `size` bytes
+ */
+int image_paths(const PathTable *table, const ImagePath *path,
+                char *input_path, char *output_path, size_t size)
+{
+    return path_table_join(table, path->input_dir, path->name, input_path, size) &&
+           path_table_join(table, path->output_dir, path->output_name, output_path, size);
+}
+
+/**
+ * @brief Publica um lote montado fora do mutex
+ *
+ * A varredura, o manifesto e a ordenação usam uma tabela e um array
+ * próprios, sem travar a fila; aqui eles apenas substituem os do lote
+ * anterior em uma seção crítica curta, e as trabalhadoras são acordadas.
+ *
+ * @param queue Fila (lote anterior concluído)
+ * @param paths Imagens a processar seguidas das duplicatas (a fila assume a posse)
+ * @param count Imagens a processar
+ * @param duplicates Duplicatas guardadas após as imagens
+ * @param table Tabela dos caminhos de `paths` (a fila assume o conteúdo)
+ */
+void queue_load(Queue *queue, ImagePath *paths, int count, int duplicates, PathTable *table)
+{
+    lock_stats_lock(&queue->mutex);
+    free(queue->paths);
+    path_table_free(&queue->table);
+    queue->paths = paths;
+    queue->table = *table;
+    queue->capacity = count > 0 ? count : 1;
+    queue->size = count;
+    queue->duplicates = duplicates;
+    queue->names_tail = 0;
+    queue->current = 0;
+    queue->processed = 0;
+    queue->failed = 0;
+
+    /*
+     * SUSPENSÃO CONTROLADA - queue_cond
+     *
+     * Acorda TODAS as threads trabalhadoras esperando por trabalho
+     */
+    pthread_cond_broadcast(&queue->queue_cond);
+    pthread_mutex_unlock(&queue->mutex);
+    path_table_init(table);
+}
+
+/**
+ * @brief Prepara a fila para receber imagens continuamente via queue_push
+ *
+ * @param queue Fila
+ * @param capacity Máximo de imagens aguardando processamento
+ * @return 1 se sucesso, 0 se falha de memória
+ */
+int queue_reset_stream(Queue *queue, int capacity)
+{
+    ImagePath *paths = calloc(capacity, sizeof(ImagePath));
+    if (!paths)
+        return 0;
+
+    lock_stats_lock(&queue->mutex);
+    free(queue->paths);
+    queue->paths = paths;
+    path_table_free(&queue->table);
+    queue->capacity = capacity;
+    queue->size = 0;
+    queue->duplicates = 0;
+    queue->names_tail = 0;
+    queue->current = 0;
+    queue->processed = 0;
+    queue->failed = 0;
+    pthread_mutex_unlock(&queue->mutex);
+    return 1;
+}
+
+/**
+ * @brief Insere uma imagem na fila, bloqueando enquanto ela estiver cheia
+ *
+ * @param queue Fila preparada com queue_reset_stream
+ * @param input_path Caminho completo da imagem de entrada
+ * @param output_path Caminho completo da imagem de saída
+ * @return 1 se inserida, 0 se o programa está terminando ou falta memória
+ */
+int queue_push(Queue *queue, const char *input_path, const char *output_path)
+{
+    lock_stats_lock(&queue->mutex);
+
+    /*
+     * SUSPENSÃO CONTROLADA - space_cond
+     *
+     * Fila limitada: o produtor dorme até que uma thread trabalhadora retire
+     * uma imagem, em vez de acumular memória sem limite
+     */
+    int woken = 0;
+    while (queue->size - queue->current >= queue->capacity && !queue->should_exit)
+    {
+        lock_stats_wait(&queue->space_cond, &queue->mutex, &woken);
+    }
+
+    if (queue->should_exit)
+    {
+        pthread_mutex_unlock(&queue->mutex);
+        return 0;
+    }
+
+    /*
+     * ARENA DE NOMES LIMITADA À JANELA
+     *
+     * As imagens saem na ordem em que entraram, então os nomes antes de
+     * names_tail já foram copiados e não são mais referenciados. Quando a
+     * arena precisaria crescer e ao menos metade dela é de nomes descartados,
+     * os nomes pendentes vão para o início e os deslocamentos das imagens na
+     * fila são corrigidos: a arena acompanha as imagens que aguardam, e não a
+     * execução inteira
+     */
+    PathTable *table = &queue->table;
+    size_t needed = strlen(input_path) + strlen(output_path) + 2;
+    if (table->names_size + needed > table->names_capacity && queue->names_tail >= table->names_size / 2)
+    {
+        uint32_t dropped = (uint32_t)queue->names_tail;
+        path_table_drop_names(table, dropped);
+        for (int i = queue->current; i < queue->size; i++)
+        {
+            queue->paths[i % queue->capacity].name -= dropped;
+            queue->paths[i % queue->capacity].output_name -= dropped;
+        }
+        queue->names_tail = 0;
+    }
+
+    ImagePath path = {0};
+    if (!path_table_add_path(table, input_path, &path.input_dir, &path.name) ||
+        !path_table_add_path(table, output_path, &path.output_dir, &path.output_name))
+    {
+        pthread_mutex_unlock(&queue->mutex);
+        return 0;
+    }
+    queue->paths[queue->size % queue->capacity] = path;
+    queue->size++;
+
+    pthread_cond_signal(&queue->queue_cond);
+    pthread_mutex_unlock(&queue->mutex);
+    return 1;
+}
+
+/**
+ * @brief Retira a próxima imagem da fila
+ *
+ * A imagem é copiada para `path` e seus caminhos completos são montados nos
+ * buffers da thread chamadora, liberando a posição do buffer para o produtor.
+ * Se um caminho não couber, input_path fica vazio e a imagem falha.
+ *
+ * @param queue Fila
+ * @param worker_id Identificador da thread trabalhadora (0, 1, ...)
+ * @param path Recebe a imagem
+ * @param input_path Buffer da thread para o caminho de entrada
+ * @param output_path Buffer da thread para o caminho de saída
+ * @param size Tamanho de cada buffer
+ * @return Índice da imagem na fila, ou -1 quando o programa está terminando
+ */
+int get_next_image(Queue *queue, int worker_id, ImagePath *path,
+                   char *input_path, char *output_path, size_t size)
+{
+    lock_stats_lock(&queue->mutex);
+
+    /*
+     * SUSPENSÃO CONTROLADA - queue_cond
+     *
+     * 1. Verifica se fila está vazia (current >= size) ou se programa está terminando
+     * 2. Enquanto não houver trabalho (ou esta thread estiver acima do limite de
+     *    threads ativas) E programa não estiver terminando:
+     *    - Suspende esta thread até que haja trabalho ou programa termine
+     *
+     * Quem insere trabalho (reload_queue, queue_push) ou encerra (queue_shutdown)
+     * é responsável por acordar as threads; sinalizar aqui faria as threads
+     * ociosas acordarem umas às outras indefinidamente
+    */
+    int woken = 0;
+    while ((queue->current >= queue->size || worker_id >= queue->active_limit) &&
+           !queue->should_exit)
+    {
+        /*
+         * pthread_cond_wait automaticamente:
+         * 1. Libera o mutex enquanto a thread dorme
+         * 2. Readquire o mutex quando a thread acorda
+         *
+         * As threads acima do limite esperam em parked_cond: se dormissem em
+         * queue_cond, o sinal de queue_push poderia acordar uma delas, que
+         * voltaria a dormir e deixaria a imagem sem ninguém para processá-la
+        */
+        if (worker_id >= queue->active_limit)
+            lock_stats_wait(&queue->parked_cond, &queue->mutex, &woken);
+        else
+            lock_stats_wait(&queue->queue_cond, &queue->mutex, &woken);
+    }
+
+    // Se programa está terminando, retorna -1 para iniciar término da thread
+    if (queue->should_exit)
+    {
+        pthread_mutex_unlock(&queue->mutex);
+        return -1;
+    }
+
+    // Obtém próxima imagem e incrementa contador atomicamente
+    int index = queue->current++;
+    *path = queue->paths[index % queue->capacity];
+    if (!image_paths(&queue->table, path, input_path, output_path, size))
+        input_path[0] = 0;
+
+    // O nome de saída é o último inserido para a imagem (queue_push)
+    queue->names_tail = path->output_name + strlen(path_table_name(&queue->table, path->output_name)) + 1;
+
+    // Libera uma posição para o produtor de uma fila limitada
+    pthread_cond_signal(&queue->space_cond);
+
+    pthread_mutex_unlock(&queue->mutex);
+
+    return index;
+}
+
+/**
+ * @brief Registra o resultado de uma imagem retirada com get_next_image
+ *
+ * @param queue Fila
+ * @param index Índice retornado por get_next_image
+ * @param success 1 se a saída foi gravada
+ * @param pixels Pixels da imagem processada
+ */
+void complete_image(Queue *queue, int index, int success, int64_t pixels)
+{
+    lock_stats_lock(&queue->mutex);
+
+    /*
+     * No modo em lote cada posição pertence a uma única imagem, e o indicador
+     * é lido depois pelo manifesto e pela deduplicação. Nos modos contínuos a
+     * posição pode já ter sido reutilizada, mas o indicador não é consultado
+     */
+    queue->paths[index % queue->capacity].done = success;
+    if (success)
+    {
+        queue->processed++;
+        queue->pixels += pixels;
+    }
+    else
+        queue->failed++;
+
+    /*
+     * SUSPENSÃO CONTROLADA - done_cond
+     *
+     * Se esta foi a última imagem da fila (processadas + falhas == size):
+     * - Sinaliza para a thread principal
+     * - Thread principal pode continuar o fluxo
+    */
+    if (queue->processed + queue->failed == queue->size)
+    {
+        pthread_cond_signal(&queue->done_cond);
+    }
+
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+/*
+ * Suspende a thread chamadora até que todas as imagens inseridas terminem.
+ * Deve ser chamada com o mutex da fila já bloqueado.
+ */
+void queue_wait_done(Queue *queue)
+{
+    /*
+     * SUSPENSÃO CONTROLADA - done_cond
+     *
+     * Thread principal dorme até que a última thread a processar uma imagem envie esse sinal
+     */
+    int woken = 0;
+    while (queue->processed + queue->failed < queue->size && !queue->should_exit)
+    {
+        lock_stats_wait(&queue->done_cond, &queue->mutex, &woken);
+    }
+}
+
+/*
+ * SUSPENSÃO CONTROLADA - queue_cond
+ *
+ * 1. Bloqueia mutex para acessar estado compartilhado
+ * 2. Define flag de saída como verdadeira
+ * 3. Acorda TODAS as threads que estejam esperando com broadcast
+ * 4. Libera mutex para que as threads possam verificar a flag e terminar
+ */
+void queue_shutdown(Queue *queue)
+{
+    lock_stats_lock(&queue->mutex);
+    queue->should_exit = 1;
+    pthread_cond_broadcast(&queue->queue_cond);
+    pthread_cond_broadcast(&queue->space_cond);
+    pthread_cond_broadcast(&queue->parked_cond);
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+/*
+ * Altera quantas trabalhadoras podem retirar imagens. As que ficam acima do
+ * limite terminam a imagem atual e são suspensas em parked_cond; ao aumentar o
+ * limite, as suspensas são acordadas para reavaliar. Ao diminuir, as que
+ * esperam em queue_cond são acordadas para passarem a parked_cond, deixando
+ * em queue_cond apenas threads que podem consumir o próximo sinal.
+ */
+void queue_set_active_limit(Queue *queue, int limit)
+{
+    lock_stats_lock(&queue->mutex);
+    if (limit > queue->active_limit)
+        pthread_cond_broadcast(&queue->parked_cond);
+    else if (limit < queue->active_limit)
+        pthread_cond_broadcast(&queue->queue_cond);
+    queue->active_limit = limit;
+    pthread_mutex_unlock(&queue->mutex);
+}
@@ -0,0 +1,534 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include "stream.h"
+#include "bulkedit.h"
+#include "tar.h"
+#include "affinity.h"
+#include "file_utils.h"
+
+// Maior imagem aceita em um quadro do fluxo
+#define MAX_FRAME_SIZE ((uint64_t)1024 * 1024 * 1024)
+// Buffer dos fluxos enquadrados (lidos e escritos em blocos grandes)
+#define STREAM_BUFFER_SIZE (1024 * 1024)
+
+// Sem quadro (fim da lista livre)
+#define NO_FRAME -1
+
+/*
+ * Imagem do fluxo, da leitura até a escrita do resultado
+ */
+typedef struct
+{
+    struct Stream *stream;
+    char *name;             // Nome do membro ou arquivo, ou NULL (formato "len")
+    unsigned char *input;   // Bytes lidos (NULL se a leitura falhou); liberados quando o pool termina
+    size_t input_size;
+    int64_t mtime;
+    int mode;
+    uint64_t sequence;      // Posição na entrada
+    BulkEditResult result;
+    int ready;              // Resultado disponível para a escrita
+    int next;               // Próximo quadro na lista livre
+} Frame;
+
+/*
+ * Diretório de entrada, lido em ordem de nome
+ */
+typedef struct
+{
+    struct dirent **entries;
+    int count;
+    int next;
+} DirSource;
+
+/*
+ * Fluxo em andamento
+ *
+ * A thread principal lê os quadros e os submete ao pool; as threads do pool
+ * marcam os resultados; uma única thread escritora os grava no destino. No
+ * máximo `window` quadros ficam em andamento, o que limita a memória e o
+ * quanto a saída pode se adiantar. `order` é um anel com o índice dos
+ * quadros na ordem em que devem ser escritos: a de leitura (ordenado) ou a
+ * de conclusão (--unordered).
+ *
+ * 1. mutex - Exclusão mútua sobre os quadros e contadores
+ * 2. ready_cond - A escritora espera o próximo resultado
+ * 3. space_cond - A leitora espera um quadro livre
+ */
+typedef struct Stream
+{
+    const StreamEnds *ends;
+    DirSource dir;
+    int ordered;
+    Frame *frames;
+    int *order;
+    int window;
+    int free_head;
+    uint64_t submitted;     // Quadros lidos e submetidos
+    uint64_t completed;     // Quadros concluídos pelo pool
+    uint64_t written;       // Quadros já tratados pela escritora
+    int input_done;
+    int write_error;
+
+    // Atualizados apenas pela escritora
+    int processed;
+    int failed;
+    int64_t pixels;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t ready_cond;
+    pthread_cond_t space_cond;
+} Stream;
+
+static uint32_t read_be32(const unsigned char *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void write_be32(unsigned char *p, uint32_t value)
+{
+    p[0] = (unsigned char)(value >> 24);
+    p[1] = (unsigned char)(value >> 16);
+    p[2] = (unsigned char)(value >> 8);
+    p[3] = (unsigned char)value;
+}
+
+// Imagens regulares do diretório de entrada
+static int select_image(const struct dirent *entry)
+{
+    return entry->d_type == DT_REG && is_image_file(entry->d_name);
+}
+
+// Próxima imagem do diretório; um arquivo ilegível vira um quadro sem dados
+static int read_dir_frame(Stream *stream, Frame *frame)
+{
+    DirSource *dir = &stream->dir;
+    if (dir->next == dir->count)
+        return 0;
+    const char *name = dir->entries[dir->next++]->d_name;
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", stream->ends->input_dir, name);
+
+    struct stat st;
+    frame->name = strdup(name);
+    frame->input = stat(path, &st) == 0 ? read_file(path, &frame->input_size) : NULL;
+    frame->mtime = frame->input ? st.st_mtime : 0;
+    frame->mode = frame->input ? (int)(st.st_mode & 07777) : 0644;
+    return frame->name ? 1 : -1;
+}
+
+/**
+ * @brief Lê o próximo quadro da origem
+ *
+ * Formato "len": tamanho em 4 bytes big-endian seguido da imagem.
+ * Formato "tar": cada arquivo regular do tar é uma imagem.
+ *
+ * @return 1 se leu um quadro, 0 no fim da entrada, -1 se a entrada é inválida
+ */
+static int read_frame(Stream *stream, Frame *frame)
+{
+    FILE *in = stream->ends->in;
+    if (!in)
+        return read_dir_frame(stream, frame);
+
+    if (stream->ends->in_format == STREAM_TAR)
+    {
+        TarMember member;
+        int status = tar_next_member(in, &member);
+        if (status <= 0)
+            return status;
+        if (member.size > MAX_FRAME_SIZE || !(frame->input = tar_read_data(in, &member)))
+        {
+            free(member.name);
+            return -1;
+        }
+        frame->name = member.name;
+        frame->input_size = member.size;
+        frame->mtime = member.mtime;
+        frame->mode = member.mode;
+        return 1;
+    }
+
+    unsigned char header[4];
+    size_t got = fread(header, 1, sizeof(header), in);
+    if (got == 0)
+        return 0;
+    uint32_t size = read_be32(header);
+    if (got != sizeof(header) || size > MAX_FRAME_SIZE)
+        return -1;
+    frame->input = malloc(size ? size : 1);
+    if (!frame->input || fread(frame->input, 1, size, in) != size)
+    {
+        free(frame->input);
+        frame->input = NULL;
+        return -1;
+    }
+    frame->name = NULL;
+    frame->input_size = size;
+    frame->mtime = 0;
+    frame->mode = 0644;
+    return 1;
+}
+
+// Nome relativo sem componentes ".." (membros de tar não podem sair do diretório de saída)
+static int is_safe_name(const char *name)
+{
+    for (const char *p = name; *p;)
+    {
+        size_t len = strcspn(p, "/");
+        if (len == 2 && p[0] == '.' && p[1] == '.')
+            return 0;
+        p += len;
+        p += *p == '/';
+    }
+    return 1;
+}
+
+/**
+ * @brief Grava um resultado no diretório de saída, criando os subdiretórios do nome
+ *
+ * @return 1 se sucesso, 0 se o nome é inseguro ou a gravação falhou
+ */
+static int write_dir_frame(Stream *stream, const Frame *frame)
+{
+    char generated[32];
+    const char *name = frame->name;
+    if (!name)
+    {
+        snprintf(generated, sizeof(generated), "%08llu.jpg", (unsigned long long)frame->sequence);
+        name = generated;
+    }
+    while (name[0] == '/' || (name[0] == '.' && name[1] == '/'))
+        name++;
+    if (!name[0] || !is_safe_name(name))
+        return 0;
+
+    const char *output_dir = stream->ends->output_dir;
+    char path[PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s/%s", output_dir, name) >= (int)sizeof(path))
+        return 0;
+    char *slash = strrchr(path, '/');
+    if (slash > path + strlen(output_dir))
+    {
+        *slash = 0;
+        int made = make_dirs(path);
+        *slash = '/';
+        if (!made)
+            return 0;
+    }
+    return write_file(path, frame->result.output, frame->result.output_size);
+}
+
+/**
+ * @brief Grava o resultado de um quadro no destino
+ *
+ * No formato "len" uma imagem que falhou vira um quadro vazio, mantendo a
+ * correspondência de um para um com a entrada; no "tar" ela é omitida.
+ *
+ * @return 1 se sucesso, 0 se o destino não aceita mais escritas
+ */
+static int write_frame(Stream *stream, const Frame *frame)
+{
+    const BulkEditResult *result = &frame->result;
+    FILE *out = stream->ends->out;
+    if (stream->ends->out_format == STREAM_TAR)
+    {
+        if (!result->success)
+            return 1;
+        char name[32];
+        if (!frame->name)
+            snprintf(name, sizeof(name), "%08llu.jpg", (unsigned long long)frame->sequence);
+        return tar_write_member(out, frame->name ? frame->name : name, result->output,
+                                result->output_size, frame->mtime, frame->mode);
+    }
+
+    unsigned char header[4];
+    size_t size = result->success ? result->output_size : 0;
+    write_be32(header, (uint32_t)size);
+    return fwrite(header, 1, sizeof(header), out) == sizeof(header) &&
+           fwrite(result->output, 1, size, out) == size;
+}
+
+// Callback do pool: marca o resultado e acorda a escritora
+static void on_result(int64_t job, const BulkEditResult *result, void *context)
+{
+    (void)job;
+    Frame *frame = context;
+    Stream *stream = frame->stream;
+    free(frame->input);
+    frame->input = NULL;
+
+    pthread_mutex_lock(&stream->mutex);
+    frame->result = *result;
+    frame->ready = 1;
+    if (!stream->ordered)
+        stream->order[stream->completed % stream->window] = (int)(frame - stream->frames);
+    stream->completed++;
+
+    // SUSPENSÃO CONTROLADA - ready_cond: acorda a escritora
+    pthread_cond_signal(&stream->ready_cond);
+    pthread_mutex_unlock(&stream->mutex);
+}
+
+// Quadro a escrever em seguida, ou NO_FRAME se ainda não está pronto; chamada com o mutex travado
+static int next_to_write(const Stream *stream)
+{
+    if (stream->written == (stream->ordered ? stream->submitted : stream->completed))
+        return NO_FRAME;
+    int index = stream->order[stream->written % stream->window];
+    return stream->frames[index].ready ? index : NO_FRAME;
+}
+
+static void *writer_thread(void *arg)
+{
+    Stream *stream = arg;
+
+    pthread_mutex_lock(&stream->mutex);
+    while (1)
+    {
+        /*
+         * SUSPENSÃO CONTROLADA - ready_cond
+         *
+         * A escritora dorme até o próximo quadro (na ordem escolhida) ficar
+         * pronto, ou até a entrada acabar e tudo ter sido escrito
+         */
+        int index;
+        while ((index = next_to_write(stream)) == NO_FRAME &&
+               !(stream->input_done && stream->written == stream->submitted))
+        {
+            pthread_cond_wait(&stream->ready_cond, &stream->mutex);
+        }
+        if (index == NO_FRAME)
+            break;
+        int write_error = stream->write_error;
+        pthread_mutex_unlock(&stream->mutex);
+
+        // Escreve fora do mutex, enquanto o pool segue com os demais quadros
+        Frame *frame = &stream->frames[index];
+        if (frame->result.success && !stream->ends->out && !write_dir_frame(stream, frame))
+        {
+            fprintf(stderr, "Erro ao gravar %s em %s\n", frame->name ? frame->name : "quadro",
+                    stream->ends->output_dir);
+            frame->result.success = 0;
+        }
+        if (frame->result.success)
+        {
+            stream->processed++;
+            stream->pixels += frame->result.pixels;
+        }
+        else
+        {
+            stream->failed++;
+            if (frame->name)
+                fprintf(stderr, "Falha ao processar %s\n", frame->name);
+            else
+                fprintf(stderr, "Falha ao processar o quadro %llu\n", (unsigned long long)frame->sequence);
+        }
+        if (stream->ends->out && !write_error && !write_frame(stream, frame))
+            write_error = 1;
+        bulkedit_free(frame->result.output);
+        free(frame->name);
+        memset(&frame->result, 0, sizeof(frame->result));
+        frame->name = NULL;
+
+        pthread_mutex_lock(&stream->mutex);
+        stream->write_error = write_error;
+        frame->ready = 0;
+        frame->next = stream->free_head;
+        stream->free_head = index;
+        stream->written++;
+
+        // SUSPENSÃO CONTROLADA - space_cond: libera a leitora
+        pthread_cond_signal(&stream->space_cond);
+    }
+    pthread_mutex_unlock(&stream->mutex);
+    return NULL;
+}
+
+// Reserva um quadro livre, esperando a escritora liberar um se preciso
+static int take_frame(Stream *stream)
+{
+    pthread_mutex_lock(&stream->mutex);
+
+    /*
+     * SUSPENSÃO CONTROLADA - space_cond
+     *
+     * Com `window` quadros em andamento, a leitura para até a escritora
+     * gravar um deles (a entrada não se adianta indefinidamente à saída)
+     */
+    while (stream->free_head == NO_FRAME && !stream->write_error)
+    {
+        pthread_cond_wait(&stream->space_cond, &stream->mutex);
+    }
+    int index = stream->write_error ? NO_FRAME : stream->free_head;
+    if (index != NO_FRAME)
+        stream->free_head = stream->frames[index].next;
+    pthread_mutex_unlock(&stream->mutex);
+    return index;
+}
+
+static void free_dir_source(DirSource *dir)
+{
+    for (int i = 0; i < dir->count; i++)
+        free(dir->entries[i]);
+    free(dir->entries);
+}
+
+static int stream_init(Stream *stream, const StreamEnds *ends, const Options *opts)
+{
+    memset(stream, 0, sizeof(*stream));
+    stream->ends = ends;
+    if (!ends->in)
+    {
+        stream->dir.count = scandir(ends->input_dir, &stream->dir.entries, select_image, alphasort);
+        if (stream->dir.count < 0)
+            return 0;
+    }
+    stream->ordered = !opts->unordered;
+    stream->window = opts->queue_size;
+    stream->frames = calloc(stream->window, sizeof(Frame));
+    stream->order = calloc(stream->window, sizeof(int));
+    if (!stream->frames || !stream->order)
+    {
+        free(stream->frames);
+        free(stream->order);
+        free_dir_source(&stream->dir);
+        return 0;
+    }
+    stream->free_head = NO_FRAME;
+    for (int i = stream->window - 1; i >= 0; i--)
+    {
+        stream->frames[i].stream = stream;
+        stream->frames[i].next = stream->free_head;
+        stream->free_head = i;
+    }
+    pthread_mutex_init(&stream->mutex, NULL);
+    pthread_cond_init(&stream->ready_cond, NULL);
+    pthread_cond_init(&stream->space_cond, NULL);
+    return 1;
+}
+
+static void stream_destroy(Stream *stream)
+{
+    pthread_mutex_destroy(&stream->mutex);
+    pthread_cond_destroy(&stream->ready_cond);
+    pthread_cond_destroy(&stream->space_cond);
+    free(stream->frames);
+    free(stream->order);
+    free_dir_source(&stream->dir);
+}
+
+/**
+ * @brief Modo fluxo: transforma as imagens da origem e as grava no destino
+ *
+ * Os quadros são lidos em sequência por esta thread e decodificados e
+ * codificados em paralelo pelo pool da libbulkedit. Por padrão o destino
+ * recebe as imagens na ordem da origem; com --unordered, na ordem de
+ * conclusão, sem que uma imagem lenta segure as seguintes.
+ *
+ * @param ends Origem (fluxo enquadrado ou diretório) e destino
+ * @param opts Opções (filtro, qualidade, threads e tamanho da janela)
+ * @param summary Resumo da execução
+ * @return 1 se a origem foi lida até o fim e o destino gravado, 0 se falha
+ */
+int run_stream(const StreamEnds *ends, const Options *opts, RunSummary *summary)
+{
+    memset(summary, 0, sizeof(*summary));
+    Stream stream;
+    if (!stream_init(&stream, ends, opts))
+        return 0;
+    BulkEditPool *pool = bulkedit_pool_create(opts->threads > 0 ? opts->threads : 0);
+    if (!pool)
+    {
+        stream_destroy(&stream);
+        return 0;
+    }
+    bulkedit_pool_set_quality(pool, opts->quality);
+
+    // Um leitor que fecha a saída não deve derrubar o processo: a escrita falha e é relatada
+    signal(SIGPIPE, SIG_IGN);
+    if (ends->in)
+        setvbuf(ends->in, NULL, _IOFBF, STREAM_BUFFER_SIZE);
+    if (ends->out)
+        setvbuf(ends->out, NULL, _IOFBF, STREAM_BUFFER_SIZE);
+
+    struct timeval start_time, end_time;
+    gettimeofday(&start_time, NULL);
+
+    pthread_t writer;
+    if (pthread_create(&writer, NULL, writer_thread, &stream) != 0)
+    {
+        fprintf(stderr, "Falha ao criar a thread de gravação do fluxo\n");
+        bulkedit_pool_destroy(pool);
+        stream_destroy(&stream);
+        return 0;
+    }
+
+    int read_status;
+    int index;
+    while ((index = take_frame(&stream)) != NO_FRAME)
+    {
+        Frame *frame = &stream.frames[index];
+        read_status = read_frame(&stream, frame);
+        if (read_status <= 0)
+        {
+            // Devolve o quadro não usado
+            pthread_mutex_lock(&stream.mutex);
+            frame->next = stream.free_head;
+            stream.free_head = index;
+            pthread_mutex_unlock(&stream.mutex);
+            break;
+        }
+
+        pthread_mutex_lock(&stream.mutex);
+        if (stream.ordered)
+            stream.order[stream.submitted % stream.window] = index;
+        frame->sequence = stream.submitted++;
+        pthread_mutex_unlock(&stream.mutex);
+
+        if (!frame->input || bulkedit_submit_buffer_callback(pool, frame->input, frame->input_size,
+                                                             opts->filter, on_result, frame) < 0)
+        {
+            BulkEditResult failed = {0};
+            on_result(-1, &failed, frame);
+        }
+    }
+    if (index == NO_FRAME)
+        read_status = 0;
+
+    pthread_mutex_lock(&stream.mutex);
+    stream.input_done = 1;
+    pthread_cond_signal(&stream.ready_cond);
+    pthread_mutex_unlock(&stream.mutex);
+    pthread_join(writer, NULL);
+
+    int ok = read_status == 0 && !stream.write_error;
+    if (ok && ends->out && ends->out_format == STREAM_TAR)
+        ok = tar_write_end(ends->out);
+    if (ends->out && fflush(ends->out) != 0)
+        ok = 0;
+    if (read_status < 0)
+        fprintf(stderr, "Entrada do fluxo inválida ou truncada após %llu imagens\n",
+                (unsigned long long)stream.submitted);
+    if (stream.write_error)
+        fprintf(stderr, "Erro ao gravar a saída do fluxo\n");
+
+    gettimeofday(&end_time, NULL);
+    summary->processed = stream.processed;
+    summary->failed = stream.failed;
+    summary->pixels = stream.pixels;
+    summary->elapsed = (end_time.tv_sec - start_time.tv_sec) +
+                       (end_time.tv_usec - start_time.tv_usec) / 1e6;
+    summary->threads = opts->threads > 0 ? opts->threads : available_cpus();
+
+    bulkedit_pool_destroy(pool);
+    stream_destroy(&stream);
+    return ok;
+}
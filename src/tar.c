@@ -0,0 +1,344 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include "tar.h"
+
+// Maior caminho aceito em um membro (nomes longos GNU e pax)
+#define TAR_MAX_NAME 4096
+
+/*
+ * Cabeçalho ustar (POSIX.1-1988), um bloco de 512 bytes
+ */
+typedef struct
+{
+    char name[100];
+    char mode[8];
+    char uid[8];
+    char gid[8];
+    char size[12];
+    char mtime[12];
+    char checksum[8];
+    char typeflag;
+    char linkname[100];
+    char magic[6];
+    char version[2];
+    char uname[32];
+    char gname[32];
+    char devmajor[8];
+    char devminor[8];
+    char prefix[155];
+    char padding[12];
+} TarHeader;
+
+// Lê um campo numérico: octal ou, com o bit alto no primeiro byte, base 256 (GNU)
+static uint64_t parse_number(const char *field, size_t len)
+{
+    const unsigned char *p = (const unsigned char *)field;
+    uint64_t value = 0;
+    if (p[0] & 0x80)
+    {
+        value = p[0] & 0x7F;
+        for (size_t i = 1; i < len; i++)
+            value = (value << 8) | p[i];
+        return value;
+    }
+
+    size_t i = 0;
+    while (i < len && (p[i] == ' ' || p[i] == 0))
+        i++;
+    for (; i < len && p[i] >= '0' && p[i] <= '7'; i++)
+        value = (value << 3) | (uint64_t)(p[i] - '0');
+    return value;
+}
+
+static unsigned header_checksum(const TarHeader *header)
+{
+    const unsigned char *p = (const unsigned char *)header;
+    unsigned sum = 0;
+    for (size_t i = 0; i < sizeof(TarHeader); i++)
+    {
+        int in_checksum = i >= offsetof(TarHeader, checksum) &&
+                          i < offsetof(TarHeader, checksum) + sizeof(header->checksum);
+        sum += in_checksum ? ' ' : p[i];
+    }
+    return sum;
+}
+
+static int is_zero_block(const TarHeader *header)
+{
+    const unsigned char *p = (const unsigned char *)header;
+    for (size_t i = 0; i < sizeof(TarHeader); i++)
+    {
+        if (p[i])
+            return 0;
+    }
+    return 1;
+}
+
+static uint64_t padded_size(uint64_t size)
+{
+    return (size + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE * TAR_BLOCK_SIZE;
+}
+
+// Descarta bytes de um fluxo que pode não permitir seek (ex.: stdin)
+static int skip_bytes(FILE *file, uint64_t count)
+{
+    char buffer[8192];
+    while (count > 0)
+    {
+        size_t chunk = count < sizeof(buffer) ? (size_t)count : sizeof(buffer);
+        if (fread(buffer, 1, chunk, file) != chunk)
+            return 0;
+        count -= chunk;
+    }
+    return 1;
+}
+
+// Lê os dados de um cabeçalho auxiliar (nome longo GNU ou pax) como texto
+static char *read_text(FILE *file, uint64_t size)
+{
+    if (size > TAR_MAX_NAME * 4)
+        return NULL;
+    char *text = malloc(size + 1);
+    if (!text)
+        return NULL;
+    if (fread(text, 1, size, file) != size || !skip_bytes(file, padded_size(size) - size))
+    {
+        free(text);
+        return NULL;
+    }
+    text[size] = 0;
+    return text;
+}
+
+// Extrai "path" de registros pax ("<tamanho> <chave>=<valor>\n")
+static char *pax_path(const char *records, uint64_t size)
+{
+    const char *p = records;
+    const char *end = records + size;
+    char *path = NULL;
+    while (p < end)
+    {
+        char *after;
+        long len = strtol(p, &after, 10);
+        if (len <= 0 || *after != ' ' || p + len > end)
+            break;
+        const char *key = after + 1;
+        const char *record_end = p + len - 1;   // '\n' final
+        if ((size_t)(record_end - key) > 5 && strncmp(key, "path=", 5) == 0)
+        {
+            free(path);
+            path = strndup(key + 5, (size_t)(record_end - key - 5));
+        }
+        p += len;
+    }
+    return path;
+}
+
+/**
+ * @brief Avança até o próximo arquivo regular de um tar lido sequencialmente
+ *
+ * Diretórios, links e demais tipos são pulados; nomes longos (GNU 'L' e pax
+ * "path") são aplicados ao membro seguinte. Após o retorno, os dados do
+ * membro devem ser consumidos com tar_read_data.
+ *
+ * @param file Fluxo posicionado em um cabeçalho
+ * @param member Membro encontrado (nome alocado)
+ * @return 1 se encontrou um membro, 0 no fim do arquivo, -1 se o tar é inválido
+ */
+int tar_next_member(FILE *file, TarMember *member)
+{
+    char *long_name = NULL;
+    TarHeader header;
+    while (1)
+    {
+        size_t got = fread(&header, 1, sizeof(header), file);
+        if (got == 0 || (got == sizeof(header) && is_zero_block(&header)))
+        {
+            free(long_name);
+            return 0;
+        }
+        if (got != sizeof(header) ||
+            parse_number(header.checksum, sizeof(header.checksum)) != header_checksum(&header))
+        {
+            free(long_name);
+            return -1;
+        }
+
+        uint64_t size = parse_number(header.size, sizeof(header.size));
+        char type = header.typeflag;
+
+        if (type == 'L' || type == 'x')
+        {
+            char *text = read_text(file, size);
+            if (!text)
+            {
+                free(long_name);
+                return -1;
+            }
+            char *name = type == 'L' ? strdup(text) : pax_path(text, size);
+            free(text);
+            if (name)
+            {
+                free(long_name);
+                long_name = name;
+            }
+            continue;
+        }
+
+        if (type != '0' && type != 0 && type != '7')
+        {
+            // Diretórios, links, cabeçalhos pax globais etc.
+            if (!skip_bytes(file, padded_size(size)))
+            {
+                free(long_name);
+                return -1;
+            }
+            free(long_name);
+            long_name = NULL;
+            continue;
+        }
+
+        if (long_name)
+        {
+            member->name = long_name;
+        }
+        else
+        {
+            char name[sizeof(header.prefix) + 1 + sizeof(header.name) + 1];
+            int has_prefix = memcmp(header.magic, "ustar", 5) == 0 && header.prefix[0];
+            snprintf(name, sizeof(name), "%.*s%s%.*s",
+                     has_prefix ? (int)strnlen(header.prefix, sizeof(header.prefix)) : 0,
+                     header.prefix, has_prefix ? "/" : "",
+                     (int)strnlen(header.name, sizeof(header.name)), header.name);
+            member->name = strdup(name);
+            if (!member->name)
+                return -1;
+        }
+        member->size = size;
+        member->mtime = (int64_t)parse_number(header.mtime, sizeof(header.mtime));
+        member->mode = (int)parse_number(header.mode, sizeof(header.mode));
+        return 1;
+    }
+}
+
+/**
+ * @brief Lê os dados do membro devolvido por tar_next_member
+ *
+ * @return Dados (liberar com free), ou NULL se o fluxo terminou antes
+ */
+unsigned char *tar_read_data(FILE *file, const TarMember *member)
+{
+    unsigned char *data = malloc(member->size ? member->size : 1);
+    if (!data)
+        return NULL;
+    if (fread(data, 1, member->size, file) != member->size ||
+        !skip_bytes(file, padded_size(member->size) - member->size))
+    {
+        free(data);
+        return NULL;
+    }
+    return data;
+}
+
+static int write_padding(FILE *file, uint64_t size)
+{
+    static const char zeros[TAR_BLOCK_SIZE];
+    uint64_t padding = padded_size(size) - size;
+    return fwrite(zeros, 1, padding, file) == padding;
+}
+
+static int write_header(FILE *file, const char *name, size_t name_len, const char *prefix,
+                        size_t prefix_len, char type, uint64_t size, int64_t mtime, int mode)
+{
+    TarHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.name, name, name_len);
+    memcpy(header.prefix, prefix, prefix_len);
+    snprintf(header.mode, sizeof(header.mode), "%07o", (unsigned)mode & 07777);
+    snprintf(header.uid, sizeof(header.uid), "%07o", 0);
+    snprintf(header.gid, sizeof(header.gid), "%07o", 0);
+    if (size < 077777777777ULL)
+    {
+        snprintf(header.size, sizeof(header.size), "%011llo", (unsigned long long)size);
+    }
+    else
+    {
+        // Base 256 para membros de 8 GB ou mais
+        header.size[0] = (char)0x80;
+        for (int i = 11; i > 0; i--, size >>= 8)
+            header.size[i] = (char)(size & 0xFF);
+    }
+    snprintf(header.mtime, sizeof(header.mtime), "%011llo",
+             (unsigned long long)(mtime > 0 ? mtime : 0) & 077777777777ULL);
+    header.typeflag = type;
+    memcpy(header.magic, "ustar", 6);
+    memcpy(header.version, "00", 2);
+    snprintf(header.checksum, sizeof(header.checksum), "%06o", header_checksum(&header));
+    header.checksum[7] = ' ';
+    return fwrite(&header, 1, sizeof(header), file) == sizeof(header);
+}
+
+/**
+ * @brief Acrescenta um arquivo regular ao tar
+ *
+ * Nomes de até 100 bytes vão no cabeçalho; até 256, divididos entre prefixo
+ * e nome (ustar); maiores, em um cabeçalho de nome longo GNU.
+ *
+ * @return 1 se sucesso, 0 se falha de escrita
+ */
+int tar_write_member(FILE *file, const char *name, const void *data, uint64_t size, int64_t mtime,
+                     int mode)
+{
+    size_t len = strlen(name);
+    if (len <= sizeof(((TarHeader *)0)->name))
+    {
+        if (!write_header(file, name, len, "", 0, '0', size, mtime, mode))
+            return 0;
+    }
+    else
+    {
+        // Procura uma '/' que divida o caminho entre prefixo (155) e nome (100)
+        const char *split = NULL;
+        for (const char *p = name + len - 1; p > name; p--)
+        {
+            if (*p != '/')
+                continue;
+            if ((size_t)(name + len - (p + 1)) > sizeof(((TarHeader *)0)->name))
+                break;
+            if ((size_t)(p - name) <= sizeof(((TarHeader *)0)->prefix))
+            {
+                split = p;
+                break;
+            }
+        }
+
+        if (split)
+        {
+            if (!write_header(file, split + 1, len - (size_t)(split + 1 - name), name,
+                              (size_t)(split - name), '0', size, mtime, mode))
+                return 0;
+        }
+        else
+        {
+            if (!write_header(file, "././@LongLink", 13, "", 0, 'L', len + 1, 0, 0644) ||
+                fwrite(name, 1, len + 1, file) != len + 1 || !write_padding(file, len + 1) ||
+                !write_header(file, name, sizeof(((TarHeader *)0)->name), "", 0, '0', size, mtime,
+                              mode))
+                return 0;
+        }
+    }
+
+    return fwrite(data, 1, size, file) == size && write_padding(file, size);
+}
+
+/**
+ * @brief Fecha o tar com os dois blocos zerados do fim do arquivo
+ */
+int tar_write_end(FILE *file)
+{
+    static const char zeros[2 * TAR_BLOCK_SIZE];
+    return fwrite(zeros, 1, sizeof(zeros), file) == sizeof(zeros);
+}
@@ -0,0 +1,193 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "timing.h"
+#include "trace.h"
+
+/*
+ * Histograma log-linear: 8 faixas por potência de 2, erro relativo de no
+ * máximo 12,5% nos percentis. Valores abaixo de 8 ns são exatos; acima de
+ * 2^TIMING_MAX_BITS ns (~2,4 h) ficam na última faixa.
+ */
+#define TIMING_SUB_BITS 3
+#define TIMING_SUB_BUCKETS (1 << TIMING_SUB_BITS)
+#define TIMING_MAX_BITS 43
+#define TIMING_BUCKETS ((TIMING_MAX_BITS - TIMING_SUB_BITS + 1) * TIMING_SUB_BUCKETS)
+
+typedef struct
+{
+    uint64_t buckets[TIMING_BUCKETS];
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    int64_t pixels;
+} Histogram;
+
+/*
+ * Histogramas de uma thread
+ *
+ * Só a própria thread escreve neles, sem trava nem operação atômica; os
+ * blocos ficam numa lista global (inserção por compare-and-swap) e são
+ * somados por timing_collect depois que as threads terminam
+ */
+typedef struct ThreadTimings
+{
+    Histogram stages[STAGE_COUNT];
+    struct ThreadTimings *next;
+} ThreadTimings;
+
+static int enabled = 0;
+static ThreadTimings *all_threads = NULL;
+static __thread ThreadTimings *local = NULL;
+
+static const char *const stage_names[STAGE_COUNT] = {
+    "queue_wait", "read", "decode", "transform", "encode", "write",
+};
+
+/**
+ * @brief Liga a medição; deve ser chamada antes de criar as threads
+ */
+void timing_enable(void)
+{
+    enabled = 1;
+}
+
+/**
+ * @brief Instante atual em nanossegundos (relógio monotônico), ou 0 sem medição
+ */
+uint64_t timing_now(void)
+{
+    if (!enabled)
+        return 0;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static int bucket_index(uint64_t ns)
+{
+    if (ns < TIMING_SUB_BUCKETS)
+        return (int)ns;
+    if (ns >> TIMING_MAX_BITS)
+        return TIMING_BUCKETS - 1;
+    int msb = 63 - __builtin_clzll(ns);
+    return (msb - TIMING_SUB_BITS + 1) * TIMING_SUB_BUCKETS +
+           (int)((ns >> (msb - TIMING_SUB_BITS)) & (TIMING_SUB_BUCKETS - 1));
+}
+
+// Maior valor que cai na faixa
+static uint64_t bucket_upper(int index)
+{
+    if (index < TIMING_SUB_BUCKETS)
+        return (uint64_t)index;
+    int msb = index / TIMING_SUB_BUCKETS + TIMING_SUB_BITS - 1;
+    uint64_t sub = (uint64_t)(index % TIMING_SUB_BUCKETS);
+    uint64_t width = 1ULL << (msb - TIMING_SUB_BITS);
+    return ((TIMING_SUB_BUCKETS + sub) << (msb - TIMING_SUB_BITS)) + width - 1;
+}
+
+/**
+ * @brief Registra a duração de uma etapa no histograma da thread
+ *
+ * Com --trace, a etapa também vira um intervalo na trilha da thread
+ *
+ * @param start Valor de timing_now no início da etapa
+ * @param end Valor de timing_now no fim da etapa
+ * @param pixels Pixels da imagem (para MP/s), ou 0
+ */
+void timing_record(Stage stage, uint64_t start, uint64_t end, int64_t pixels)
+{
+    if (!enabled || end < start)
+        return;
+    if (trace_enabled())
+        trace_span(stage == STAGE_QUEUE_WAIT ? "espera" : "etapa", stage_names[stage], start, end, NULL,
+                   NULL, pixels > 0 ? "pixels" : NULL, pixels);
+    if (!local)
+    {
+        local = calloc(1, sizeof(ThreadTimings));
+        if (!local)
+            return;
+        local->next = __atomic_load_n(&all_threads, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&all_threads, &local->next, local, 0, __ATOMIC_RELEASE,
+                                            __ATOMIC_RELAXED))
+            ;
+    }
+
+    uint64_t ns = end - start;
+    Histogram *histogram = &local->stages[stage];
+    histogram->buckets[bucket_index(ns)]++;
+    histogram->count++;
+    histogram->total_ns += ns;
+    histogram->pixels += pixels;
+    if (ns > histogram->max_ns)
+        histogram->max_ns = ns;
+}
+
+// Menor faixa cujo acumulado alcança a fração `quantile` das amostras
+static uint64_t percentile(const Histogram *histogram, double quantile)
+{
+    uint64_t target = (uint64_t)(quantile * histogram->count + 0.5);
+    if (target == 0)
+        target = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < TIMING_BUCKETS; i++)
+    {
+        seen += histogram->buckets[i];
+        if (seen >= target)
+        {
+            uint64_t upper = bucket_upper(i);
+            return upper < histogram->max_ns ? upper : histogram->max_ns;
+        }
+    }
+    return histogram->max_ns;
+}
+
+/**
+ * @brief Soma os histogramas de todas as threads e calcula os percentis
+ *
+ * Deve ser chamada depois que as threads medidas terminaram
+ */
+void timing_collect(StageStats stats[STAGE_COUNT])
+{
+    memset(stats, 0, STAGE_COUNT * sizeof(StageStats));
+    Histogram *merged = calloc(STAGE_COUNT, sizeof(Histogram));
+    if (!merged)
+        return;
+
+    for (ThreadTimings *t = __atomic_load_n(&all_threads, __ATOMIC_ACQUIRE); t; t = t->next)
+    {
+        for (int s = 0; s < STAGE_COUNT; s++)
+        {
+            const Histogram *from = &t->stages[s];
+            Histogram *to = &merged[s];
+            for (int i = 0; i < TIMING_BUCKETS; i++)
+                to->buckets[i] += from->buckets[i];
+            to->count += from->count;
+            to->total_ns += from->total_ns;
+            to->pixels += from->pixels;
+            if (from->max_ns > to->max_ns)
+                to->max_ns = from->max_ns;
+        }
+    }
+
+    for (int s = 0; s < STAGE_COUNT; s++)
+    {
+        const Histogram *histogram = &merged[s];
+        stats[s].count = histogram->count;
+        stats[s].total_ns = histogram->total_ns;
+        stats[s].max_ns = histogram->max_ns;
+        stats[s].pixels = histogram->pixels;
+        if (histogram->count)
+        {
+            stats[s].p50_ns = percentile(histogram, 0.50);
+            stats[s].p90_ns = percentile(histogram, 0.90);
+            stats[s].p99_ns = percentile(histogram, 0.99);
+        }
+    }
+    free(merged);
+}
+
+const char *stage_name(Stage stage)
+{
+    return stage_names[stage];
+}
@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "trace.h"
+
+/*
+ * Linha do tempo no formato trace-event do Chrome/Perfetto (--trace)
+ *
+ * Cada thread guarda seus intervalos num vetor próprio, sem trava; os
+ * vetores ficam numa lista global (inserção por compare-and-swap) e são
+ * gravados por trace_write depois que as threads terminam. Cada thread vira
+ * uma trilha ("tid") com o nome definido por trace_set_thread.
+ */
+typedef struct
+{
+    const char *category;   // Texto estático: "etapa", "espera", "imagem", "lote"
+    const char *name;       // Texto estático
+    uint64_t start;         // Relógio monotônico, em ns
+    uint64_t end;
+    const char *text_key;   // Argumento textual (NULL = nenhum)
+    char *text;             // Cópia própria do valor
+    const char *number_key; // Argumento numérico (NULL = nenhum)
+    int64_t number;
+} TraceEvent;
+
+typedef struct ThreadTrace
+{
+    const char *role;
+    int id;
+    TraceEvent *events;
+    size_t count;
+    size_t capacity;
+    struct ThreadTrace *next;
+} ThreadTrace;
+
+static int enabled = 0;
+static uint64_t origin_ns = 0; // Instante zero da linha do tempo
+static ThreadTrace *all_threads = NULL;
+static __thread ThreadTrace *local = NULL;
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+// Vetor da thread chamadora, criado no primeiro uso
+static ThreadTrace *thread_trace(void)
+{
+    if (!local)
+    {
+        local = calloc(1, sizeof(ThreadTrace));
+        if (!local)
+            return NULL;
+        local->role = "thread";
+        local->id = -1;
+        local->next = __atomic_load_n(&all_threads, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&all_threads, &local->next, local, 0, __ATOMIC_RELEASE,
+                                            __ATOMIC_RELAXED))
+            ;
+    }
+    return local;
+}
+
+/**
+ * @brief Liga a gravação dos intervalos; deve ser chamada antes de criar as threads
+ */
+void trace_enable(void)
+{
+    origin_ns = now_ns();
+    enabled = 1;
+}
+
+int trace_enabled(void)
+{
+    return enabled;
+}
+
+/**
+ * @brief Dá nome à trilha da thread chamadora
+ *
+ * @param role Papel da thread (texto estático)
+ * @param id Índice da thread no seu papel
+ */
+void trace_set_thread(const char *role, int id)
+{
+    ThreadTrace *trace = enabled ? thread_trace() : NULL;
+    if (trace)
+    {
+        trace->role = role;
+        trace->id = id;
+    }
+}
+
+/**
+ * @brief Registra um intervalo na trilha da thread chamadora
+ *
+ * @param category Categoria do intervalo (texto estático)
+ * @param name Nome exibido (texto estático)
+ * @param start Início, no relógio de timing_now
+ * @param end Fim, no mesmo relógio
+ * @param text_key Nome do argumento textual, ou NULL
+ * @param text Valor do argumento textual (copiado)
+ * @param number_key Nome do argumento numérico, ou NULL
+ * @param number Valor do argumento numérico
+ */
+void trace_span(const char *category, const char *name, uint64_t start, uint64_t end,
+                const char *text_key, const char *text, const char *number_key, int64_t number)
+{
+    ThreadTrace *trace = enabled && end >= start ? thread_trace() : NULL;
+    if (!trace)
+        return;
+    if (trace->count == trace->capacity)
+    {
+        size_t capacity = trace->capacity ? trace->capacity * 2 : 1024;
+        TraceEvent *grown = realloc(trace->events, capacity * sizeof(TraceEvent));
+        if (!grown)
+            return;
+        trace->events = grown;
+        trace->capacity = capacity;
+    }
+
+    TraceEvent *event = &trace->events[trace->count++];
+    event->category = category;
+    event->name = name;
+    event->start = start;
+    event->end = end;
+    event->text_key = text_key;
+    event->text = text_key && text ? strdup(text) : NULL;
+    event->number_key = number_key;
+    event->number = number;
+}
+
+// Texto entre aspas com os escapes do JSON
+static void write_json_string(FILE *file, const char *text)
+{
+    fputc('"', file);
+    for (const unsigned char *c = (const unsigned char *)text; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+            fprintf(file, "\\%c", *c);
+        else if (*c < 0x20)
+            fprintf(file, "\\u%04x", *c);
+        else
+            fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+// Microssegundos desde trace_enable, com a precisão de ns do relógio
+static double trace_us(uint64_t ns)
+{
+    return ns > origin_ns ? (ns - origin_ns) / 1e3 : 0;
+}
+
+static void write_event(FILE *file, int tid, const TraceEvent *event)
+{
+    fprintf(file, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"cat\":\"%s\",\"name\":", tid, event->category);
+    write_json_string(file, event->name);
+    fprintf(file, ",\"ts\":%.3f,\"dur\":%.3f", trace_us(event->start),
+            (event->end - event->start) / 1e3);
+    if (event->text || event->number_key)
+    {
+        fprintf(file, ",\"args\":{");
+        if (event->text)
+        {
+            fprintf(file, "\"%s\":", event->text_key);
+            write_json_string(file, event->text);
+        }
+        if (event->number_key)
+            fprintf(file, "%s\"%s\":%lld", event->text ? "," : "", event->number_key,
+                    (long long)event->number);
+        fprintf(file, "}");
+    }
+    fprintf(file, "}");
+}
+
+/**
+ * @brief Grava a linha do tempo em `path` (JSON trace-event)
+ *
+ * Deve ser chamada depois que as threads registradas terminaram. Abra o
+ * arquivo em ui.perfetto.dev ou chrome://tracing.
+ *
+ * @return 1 se sucesso, 0 se falha ao gravar
+ */
+int trace_write(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+        return 0;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                  "{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\",\"args\":{\"name\":\"editor\"}}");
+
+    // Trilhas na ordem de criação: a lista cresce pela cabeça
+    int count = 0;
+    ThreadTrace *head = __atomic_load_n(&all_threads, __ATOMIC_ACQUIRE);
+    for (ThreadTrace *t = head; t; t = t->next)
+        count++;
+    int tid = count;
+    for (ThreadTrace *t = head; t; t = t->next, tid--)
+    {
+        // Threads sem nome (ex.: o pool da libbulkedit no modo fluxo) usam o número da trilha
+        char name[64];
+        snprintf(name, sizeof(name), "%s %d", t->role, t->id >= 0 ? t->id : tid);
+        fprintf(file, ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":", tid);
+        write_json_string(file, name);
+        fprintf(file, "}},\n{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_sort_index\","
+                      "\"args\":{\"sort_index\":%d}}", tid, tid);
+        for (size_t i = 0; i < t->count; i++)
+            write_event(file, tid, &t->events[i]);
+    }
+
+    fprintf(file, "\n]}\n");
+    int written = !ferror(file);
+    return fclose(file) == 0 && written;
+}
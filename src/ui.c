@@ -2,12 +2,30 @@
 #include <stdlib.h>
 #include <string.h>
 #include <dirent.h>
+#include <inttypes.h>
 #include "ui.h"
+#include "options.h"
+
+// Tamanho máximo do filtro digitado (inclui cadeias como "grayscale,invert")
+#define EDIT_TYPE_SIZE 128
+
+// Destino das mensagens e relatórios (stdout, ou stderr com --stats json)
+static FILE *report_stream;
+
+static FILE *report(void)
+{
+    return report_stream ? report_stream : stdout;
+}
+
+void set_report_stream(FILE *stream)
+{
+    report_stream = stream;
+}
 
 char *get_input_directory()
 {
     char *dir = malloc(512);
-    printf("Caminho do diretório com as imagens: ");
+    fprintf(report(), "Caminho do diretório com as imagens: ");
     if (fgets(dir, 512, stdin) != NULL)
     {
         dir[strcspn(dir, "\n")] = 0;
@@ -16,7 +34,7 @@ char *get_input_directory()
     DIR *d = opendir(dir);
     while (!d)
     {
-        printf("Diretório não encontrado. Digite novamente: ");
+        fprintf(report(), "Diretório não encontrado. Digite novamente: ");
         if (fgets(dir, 512, stdin) != NULL)
         {
             dir[strcspn(dir, "\n")] = 0;
@@ -27,29 +45,43 @@ char *get_input_directory()
     return dir;
 }
 
-int get_thread_count()
+/*
+ * Retorna o número de threads, THREADS_AUTO se o usuário escolher 'auto' ou
+ * THREADS_DEFAULT se apenas pressionar Enter
+ */
+int get_thread_count(int default_threads)
 {
-    int num_threads;
+    int num_threads = THREADS_DEFAULT;
     char buffer[32];
-    printf("\nNúmero de threads: ");
+    fprintf(report(), "\nNúmero de threads (Enter = %d, ou 'auto'): ", default_threads);
 
     while (fgets(buffer, sizeof(buffer), stdin))
     {
+        if (buffer[0] == '\n')
+        {
+            num_threads = THREADS_DEFAULT;
+            break;
+        }
+        if (strncmp(buffer, "auto", 4) == 0)
+        {
+            num_threads = THREADS_AUTO;
+            break;
+        }
         if (sscanf(buffer, "%d", &num_threads) == 1 && num_threads > 0)
         {
             break;
         }
-        printf("Número inválido. Digite um valor positivo: ");
+        fprintf(report(), "Número inválido. Digite um valor positivo ou 'auto': ");
     }
     return num_threads;
 }
 
 char *get_edit_type()
 {
-    char *edit_type = malloc(20);
-    printf("\nEscolha um tipo de filtro ou 'sair'\n");
-    printf("Tipos disponíveis: grayscale, red, green, blue, invert\n> ");
-    if (fgets(edit_type, 20, stdin) != NULL)
+    char *edit_type = malloc(EDIT_TYPE_SIZE);
+    fprintf(report(), "\nEscolha um tipo de filtro ou 'sair'\n");
+    fprintf(report(), "Tipos disponíveis: grayscale, red, green, blue, invert (ou vários: grayscale,invert)\n> ");
+    if (fgets(edit_type, EDIT_TYPE_SIZE, stdin) != NULL)
     {
         edit_type[strcspn(edit_type, "\n")] = 0;
     }
@@ -57,16 +89,283 @@ char *get_edit_type()
 }
 
 void display_processing_result(const char *edit_type, int count, double elapsed){
-    printf("Processadas %d imagens com filtro '%s' em %.2f segundos\n",
+    fprintf(report(), "Processadas %d imagens com filtro '%s' em %.2f segundos\n",
                count, edit_type, elapsed);
 }
 
-void display_final_statistics(int total_processed, double total_time, int num_threads){
-    printf("\n======= Estatísticas finais =======\n\n");
-    printf("%-25s %d\n", "Imagens processadas:", total_processed);
-    printf("%-25s %.2f %s\n", "Tempo total:", total_time, "s");
-    printf("%-25s %.2f %s\n", "Velocidade media:", 
-        total_processed / (total_time > 0 ? total_time : 1), "imagens/s");
+void display_job_result(const char *input_dir, const char *filter, const char *output_dir,
+                        int processed, int failed, int skipped, int error){
+    if (error)
+    {
+        fprintf(report(), "Job %s (%s): erro ao ler o diretório ou o manifesto\n", input_dir, filter);
+        return;
+    }
+    fprintf(report(), "Job %s (%s) -> %s: %d processadas", input_dir, filter, output_dir, processed);
+    if (failed > 0)
+        fprintf(report(), ", %d falhas", failed);
+    if (skipped > 0)
+        fprintf(report(), ", %d já atualizadas", skipped);
+    fprintf(report(), "\n");
+}
+
+void display_skipped_images(int count){
+    if (count > 0)
+        fprintf(report(), "%d imagens já atualizadas foram ignoradas (modo incremental)\n", count);
+}
+
+void display_duplicates(int linked, int duplicates){
+    fprintf(report(), "%d de %d duplicatas geradas por link a partir da imagem original\n",
+           linked, duplicates);
+}
+
+void display_affinity(const int *cpus, int num_threads){
+    fprintf(report(), "Threads fixadas nas CPUs:");
+    for (int i = 0; i < num_threads; i++)
+        fprintf(report(), " %d", cpus[i]);
+    fprintf(report(), "\n");
+}
+
+void display_controller_summary(int active, int peak, int max_threads, int adjustments){
+    fprintf(report(), "> Concorrência ajustada: %d threads ativas ao final (pico %d, máximo %d, %d ajustes)\n",
+           active, peak, max_threads, adjustments);
+}
+
+void display_io_pool(int io_threads, int queues, int peak_waiting){
+    if (queues > 1)
+        fprintf(report(), "> Pool de I/O: %d threads, %d filas por nó NUMA (até %d imagens aguardaram processamento em uma fila)\n",
+               io_threads, queues, peak_waiting);
+    else
+        fprintf(report(), "> Pool de I/O: %d threads (até %d imagens aguardaram processamento)\n",
+               io_threads, peak_waiting);
+}
+
+void display_cpu_limit_change(int cpus){
+    fprintf(report(), "Limite de CPUs alterado: %d threads ativas\n", cpus);
+    fflush(report());
+}
+
+void display_watching(const char *input_dir){
+    fprintf(report(), "Monitorando %s (Ctrl+C para encerrar)\n", input_dir);
+    fflush(report());
+}
+
+void display_daemon_listening(const char *socket_path){
+    fprintf(report(), "Aguardando pedidos em %s (Ctrl+C para encerrar)\n", socket_path);
+    fflush(report());
+}
+
+void display_unpacked(int extracted, int failed, const char *output_dir){
+    fprintf(report(), "%d imagens extraídas para %s\n", extracted, output_dir);
+    if (failed > 0)
+        fprintf(report(), "%d imagens não puderam ser extraídas\n", failed);
+}
+
+void display_final_statistics(const RunSummary *summary){
+    fprintf(report(), "\n======= Estatísticas finais =======\n\n");
+    fprintf(report(), "%-25s %d\n", "Imagens processadas:", summary->processed);
+    if (summary->failed > 0)
+        fprintf(report(), "%-25s %d\n", "Imagens com falha:", summary->failed);
+    fprintf(report(), "%-25s %.2f %s\n", "Tempo total:", summary->elapsed, "s");
+    fprintf(report(), "%-25s %.2f %s\n", "Velocidade media:", 
+        summary->processed / (summary->elapsed > 0 ? summary->elapsed : 1), "imagens/s");
+
+    fprintf(report(), "\n> Utilizando %d threads\n", summary->threads);
+}
+
+/*
+ * Resumo para scripts: uma linha JSON em `stream` (a saída padrão, exceto
+ * no modo fluxo, em que ela carrega as imagens)
+ */
+void display_summary_json(FILE *stream, const RunSummary *summary){
+    double elapsed = summary->elapsed > 0 ? summary->elapsed : 1;
+    fprintf(stream, "{\"status\":%d,\"processed\":%d,\"failed\":%d,\"skipped\":%d,\"duplicates\":%d,"
+           "\"pixels\":%" PRId64 ",\"elapsed_s\":%.3f,\"images_per_s\":%.2f,"
+           "\"megapixels_per_s\":%.2f,\"threads\":%d,\"io_threads\":%d}\n",
+           summary->status, summary->processed, summary->failed, summary->skipped,
+           summary->duplicates, summary->pixels, summary->elapsed, summary->processed / elapsed,
+           summary->pixels / 1e6 / elapsed, summary->threads, summary->io_threads);
+    fflush(stream);
+}
+
+// Vazão de uma etapa em megapixels por segundo de uma thread
+static double stage_megapixels_per_s(const StageStats *stage)
+{
+    return stage->total_ns ? stage->pixels * 1e3 / stage->total_ns : 0;
+}
 
-    printf("\n> Utilizando %d threads\n", num_threads);
+/*
+ * Percentis do tempo de cada etapa por imagem, somando todas as threads.
+ * MP/s é a vazão de uma thread na etapa (pixels / tempo gasto nela).
+ */
+void display_stage_timings(const StageStats *stats){
+    fprintf(report(), "\n======= Tempo por etapa (ms) =======\n\n");
+    fprintf(report(), "%-11s %9s %9s %9s %9s %9s %9s\n", "Etapa", "Imagens", "p50", "p90", "p99",
+            "max", "MP/s");
+    for (int s = 0; s < STAGE_COUNT; s++)
+    {
+        const StageStats *stage = &stats[s];
+        if (!stage->count)
+            continue;
+        fprintf(report(), "%-11s %9" PRIu64 " %9.2f %9.2f %9.2f %9.2f", stage_name(s), stage->count,
+                stage->p50_ns / 1e6, stage->p90_ns / 1e6, stage->p99_ns / 1e6, stage->max_ns / 1e6);
+        if (stage->pixels > 0)
+            fprintf(report(), " %9.1f\n", stage_megapixels_per_s(stage));
+        else
+            fprintf(report(), " %9s\n", "-");
+    }
+}
+
+void display_stage_timings_json(const StageStats *stats){
+    fprintf(report(), "{\"stages\":{");
+    for (int s = 0; s < STAGE_COUNT; s++)
+    {
+        const StageStats *stage = &stats[s];
+        fprintf(report(), "%s\"%s\":{\"count\":%" PRIu64 ",\"total_ms\":%.3f,\"p50_ms\":%.3f,"
+                "\"p90_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f,\"megapixels_per_s\":%.2f}",
+                s ? "," : "", stage_name(s), stage->count, stage->total_ns / 1e6, stage->p50_ns / 1e6,
+                stage->p90_ns / 1e6, stage->p99_ns / 1e6, stage->max_ns / 1e6,
+                stage_megapixels_per_s(stage));
+    }
+    fprintf(report(), "}}\n");
+    fflush(report());
+}
+
+// Soma dos contadores de todas as threads
+static LockStats total_lock_stats(const LockStats *stats, int count)
+{
+    LockStats total = {"total", -1, 0, 0, 0, 0, 0};
+    for (int i = 0; i < count; i++)
+    {
+        total.acquisitions += stats[i].acquisitions;
+        total.contended += stats[i].contended;
+        total.wait_ns += stats[i].wait_ns;
+        total.wakeups += stats[i].wakeups;
+        total.spurious += stats[i].spurious;
+    }
+    return total;
+}
+
+static void display_lock_stats_row(const LockStats *stats)
+{
+    char name[32];
+    if (stats->id >= 0)
+        snprintf(name, sizeof(name), "%s %d", stats->role, stats->id);
+    else
+        snprintf(name, sizeof(name), "%s", stats->role);
+    fprintf(report(), "%-16s %10" PRIu64 " %10" PRIu64 " %7.1f%% %10.2f %11" PRIu64 " %9" PRIu64 "\n",
+            name, stats->acquisitions, stats->contended,
+            stats->acquisitions ? stats->contended * 100.0 / stats->acquisitions : 0, stats->wait_ns / 1e6,
+            stats->wakeups, stats->spurious);
+}
+
+/*
+ * Disputa do mutex da fila e despertares das suas condições, por thread.
+ * Espúrios são despertares em que a condição continuava falsa e a thread
+ * voltou a dormir.
+ */
+void display_lock_stats(const LockStats *stats, int count){
+    fprintf(report(), "\n======= Disputa da fila =======\n\n");
+    fprintf(report(), "%-16s %10s %10s %8s %10s %11s  %s\n", "Thread", "Travas", "Disputadas", "%",
+            "Espera ms", "Despertares", "Espúrios");
+    for (int i = 0; i < count; i++)
+        display_lock_stats_row(&stats[i]);
+    LockStats total = total_lock_stats(stats, count);
+    display_lock_stats_row(&total);
+}
+
+void display_lock_stats_json(const LockStats *stats, int count){
+    LockStats total = total_lock_stats(stats, count);
+    fprintf(report(), "{\"lock_stats\":{\"threads\":[");
+    for (int i = 0; i <= count; i++)
+    {
+        const LockStats *row = i < count ? &stats[i] : &total;
+        if (i == count)
+            fprintf(report(), "],\"total\":");
+        else if (i > 0)
+            fprintf(report(), ",");
+        fprintf(report(), "{\"role\":\"%s\",\"id\":%d,\"acquisitions\":%" PRIu64 ",\"contended\":%" PRIu64
+                ",\"wait_ms\":%.3f,\"wakeups\":%" PRIu64 ",\"spurious\":%" PRIu64 "}",
+                row->role, row->id, row->acquisitions, row->contended, row->wait_ns / 1e6, row->wakeups,
+                row->spurious);
+    }
+    fprintf(report(), "}}\n");
+    fflush(report());
+}
+
+// Etapas medidas pelos contadores (as do pool de processamento)
+static const Stage counted_stages[] = {STAGE_DECODE, STAGE_TRANSFORM, STAGE_ENCODE};
+
+// Valor por mil instruções, ou -1 se algum dos contadores faltou
+static double per_kilo_instruction(const StageCounters *stage, Counter counter)
+{
+    if (!stage->available[counter] || !stage->available[COUNTER_INSTRUCTIONS] ||
+        stage->value[COUNTER_INSTRUCTIONS] <= 0)
+        return -1;
+    return stage->value[counter] * 1000 / stage->value[COUNTER_INSTRUCTIONS];
+}
+
+static double instructions_per_cycle(const StageCounters *stage)
+{
+    if (!stage->available[COUNTER_CYCLES] || !stage->available[COUNTER_INSTRUCTIONS] ||
+        stage->value[COUNTER_CYCLES] <= 0)
+        return -1;
+    return stage->value[COUNTER_INSTRUCTIONS] / stage->value[COUNTER_CYCLES];
+}
+
+static void display_counter_cell(double value, int width, int decimals)
+{
+    if (value < 0)
+        fprintf(report(), " %*s", width, "-");
+    else
+        fprintf(report(), " %*.*f", width, decimals, value);
+}
+
+/*
+ * Contadores de hardware por etapa, somando todas as threads. IPC baixo com
+ * muitas faltas de LLC por mil instruções indica uma etapa limitada pela
+ * memória; IPC alto, uma etapa limitada pelo processamento.
+ */
+void display_stage_counters(const StageCounters *stats, int available){
+    fprintf(report(), "\n======= Contadores de hardware por etapa =======\n\n");
+    if (!available)
+    {
+        fprintf(report(), "Contadores indisponíveis (perf_event_open falhou: verifique "
+                "kernel.perf_event_paranoid ou se a VM expõe a PMU)\n");
+        return;
+    }
+    fprintf(report(), "%-11s %9s %10s %7s %9s %12s\n", "Etapa", "Imagens", "ciclos/px", "IPC",
+            "LLC MPKI", "desvios MPKI");
+    for (size_t i = 0; i < sizeof(counted_stages) / sizeof(counted_stages[0]); i++)
+    {
+        const StageCounters *stage = &stats[counted_stages[i]];
+        if (!stage->count)
+            continue;
+        fprintf(report(), "%-11s %9" PRIu64, stage_name(counted_stages[i]), stage->count);
+        display_counter_cell(stage->available[COUNTER_CYCLES] && stage->pixels > 0
+                                 ? stage->value[COUNTER_CYCLES] / stage->pixels : -1, 10, 2);
+        display_counter_cell(instructions_per_cycle(stage), 7, 2);
+        display_counter_cell(per_kilo_instruction(stage, COUNTER_LLC_MISSES), 9, 2);
+        display_counter_cell(per_kilo_instruction(stage, COUNTER_BRANCH_MISSES), 12, 2);
+        fprintf(report(), "\n");
+    }
+}
+
+void display_stage_counters_json(const StageCounters *stats, int available){
+    fprintf(report(), "{\"perf\":{\"available\":%s,\"stages\":{", available ? "true" : "false");
+    for (size_t i = 0; i < sizeof(counted_stages) / sizeof(counted_stages[0]); i++)
+    {
+        const StageCounters *stage = &stats[counted_stages[i]];
+        fprintf(report(), "%s\"%s\":{\"count\":%" PRIu64 ",\"pixels\":%" PRId64, i ? "," : "",
+                stage_name(counted_stages[i]), stage->count, stage->pixels);
+        for (int c = 0; c < COUNTER_COUNT; c++)
+        {
+            if (stage->available[c])
+                fprintf(report(), ",\"%s\":%.0f", counter_name(c), stage->value[c]);
+            else
+                fprintf(report(), ",\"%s\":null", counter_name(c));
+        }
+        fprintf(report(), "}");
+    }
+    fprintf(report(), "}}}\n");
+    fflush(report());
 }
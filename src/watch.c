@@ -0,0 +1,245 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/inotify.h>
+#include "watch.h"
+#include "file_utils.h"
+#include "ui.h"
+
+#define PENDING_BUCKETS 1024
+
+/*
+ * Arquivo notificado que aguarda o fim do intervalo de debounce
+ *
+ * As entradas formam uma lista em ordem de prazo (cada nova notificação
+ * leva o arquivo para o fim) e uma tabela hash pelo nome
+ */
+typedef struct PendingFile
+{
+    char name[NAME_MAX + 1];
+    int64_t deadline_ms;
+    struct PendingFile *prev, *next;  // Lista ordenada por prazo
+    struct PendingFile *bucket_next;  // Encadeamento na tabela hash
+} PendingFile;
+
+typedef struct
+{
+    PendingFile *buckets[PENDING_BUCKETS];
+    PendingFile *head, *tail;
+} PendingSet;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_stop_signal(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+static int64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static unsigned bucket_of(const char *name)
+{
+    return (unsigned)(hash_bytes(name, strlen(name), 0) % PENDING_BUCKETS);
+}
+
+static void list_remove(PendingSet *set, PendingFile *file)
+{
+    if (file->prev)
+        file->prev->next = file->next;
+    else
+        set->head = file->next;
+    if (file->next)
+        file->next->prev = file->prev;
+    else
+        set->tail = file->prev;
+    file->prev = file->next = NULL;
+}
+
+static void list_append(PendingSet *set, PendingFile *file)
+{
+    file->prev = set->tail;
+    file->next = NULL;
+    if (set->tail)
+        set->tail->next = file;
+    else
+        set->head = file;
+    set->tail = file;
+}
+
+/*
+ * Registra uma notificação; notificações repetidas do mesmo arquivo
+ * apenas adiam o prazo
+ */
+static void pending_touch(PendingSet *set, const char *name, int64_t deadline_ms)
+{
+    unsigned bucket = bucket_of(name);
+    PendingFile *file = set->buckets[bucket];
+    while (file && strcmp(file->name, name) != 0)
+        file = file->bucket_next;
+
+    if (file)
+    {
+        list_remove(set, file);
+    }
+    else
+    {
+        file = calloc(1, sizeof(PendingFile));
+        if (!file)
+            return;
+        snprintf(file->name, sizeof(file->name), "%s", name);
+        file->bucket_next = set->buckets[bucket];
+        set->buckets[bucket] = file;
+    }
+    file->deadline_ms = deadline_ms;
+    list_append(set, file);
+}
+
+static void pending_remove(PendingSet *set, PendingFile *file)
+{
+    PendingFile **link = &set->buckets[bucket_of(file->name)];
+    while (*link != file)
+        link = &(*link)->bucket_next;
+    *link = file->bucket_next;
+    list_remove(set, file);
+    free(file);
+}
+
+/*
+ * Envia para a fila os arquivos cujo prazo já venceu (ou todos, se flush_all)
+ */
+static int pending_flush(PendingSet *set, Queue *queue, const char *input_dir,
+                         const char *output_dir, int flush_all)
+{
+    int64_t now = now_ms();
+    while (set->head && (flush_all || set->head->deadline_ms <= now))
+    {
+        PendingFile *file = set->head;
+        char input_path[PATH_MAX], output_path[PATH_MAX];
+        snprintf(input_path, sizeof(input_path), "%s/%s", input_dir, file->name);
+        snprintf(output_path, sizeof(output_path), "%s/%s", output_dir, file->name);
+        pending_remove(set, file);
+        if (!queue_push(queue, input_path, output_path))
+            return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Monitora o diretório de entrada e enfileira imagens à medida que chegam
+ *
+ * Usa inotify (IN_CLOSE_WRITE e IN_MOVED_TO), sem varrer o diretório. Cada
+ * arquivo só é enfileirado após `debounce_ms` sem novas notificações, o que
+ * agrupa gravações repetidas. A fila é limitada a `queue_size` imagens
+ * aguardando; quando cheia, a leitura de eventos espera as trabalhadoras.
+ *
+ * Retorna quando o processo recebe SIGINT ou SIGTERM, após enfileirar os
+ * arquivos ainda pendentes.
+ *
+ * @return 1 se encerrado normalmente, 0 se falha ao iniciar o monitoramento
+ */
+int watch_directory(Queue *queue, const char *input_dir, const char *output_dir,
+                    int queue_size, int debounce_ms)
+{
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+        return 0;
+    if (inotify_add_watch(fd, input_dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0 ||
+        !queue_reset_stream(queue, queue_size))
+    {
+        close(fd);
+        return 0;
+    }
+
+    /*
+     * Os sinais ficam bloqueados fora do ppoll, que os desbloqueia de forma
+     * atômica: um Ctrl+C entre a verificação da flag e a espera não se perde
+     */
+    struct sigaction action = {0}, old_int, old_term;
+    action.sa_handler = handle_stop_signal;
+    sigemptyset(&action.sa_mask);
+    stop_requested = 0;
+    sigaction(SIGINT, &action, &old_int);
+    sigaction(SIGTERM, &action, &old_term);
+
+    sigset_t stop_signals, old_mask, wait_mask;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, &old_mask);
+    wait_mask = old_mask;
+    sigdelset(&wait_mask, SIGINT);
+    sigdelset(&wait_mask, SIGTERM);
+
+    display_watching(input_dir);
+    fflush(stdout);
+
+    PendingSet pending = {0};
+    char buffer[64 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int ok = 1;
+
+    while (!stop_requested && ok)
+    {
+        struct timespec timeout, *timeout_ptr = NULL;
+        if (pending.head)
+        {
+            int64_t wait = pending.head->deadline_ms - now_ms();
+            if (wait < 0)
+                wait = 0;
+            timeout.tv_sec = wait / 1000;
+            timeout.tv_nsec = (wait % 1000) * 1000000;
+            timeout_ptr = &timeout;
+        }
+
+        struct pollfd pfd = {.fd = fd, .events = POLLIN};
+        int ready = ppoll(&pfd, 1, timeout_ptr, &wait_mask);
+        if (ready < 0 && errno != EINTR)
+            break;
+
+        if (ready > 0)
+        {
+            ssize_t len;
+            while ((len = read(fd, buffer, sizeof(buffer))) > 0)
+            {
+                int64_t deadline = now_ms() + debounce_ms;
+                for (char *p = buffer; p < buffer + len;)
+                {
+                    struct inotify_event *event = (struct inotify_event *)p;
+                    if (event->mask & IN_Q_OVERFLOW)
+                        fprintf(stderr, "Aviso: fila do inotify transbordou, eventos perdidos\n");
+                    else if (event->len > 0 && !(event->mask & IN_ISDIR) &&
+                             is_image_file(event->name))
+                        pending_touch(&pending, event->name, deadline);
+                    p += sizeof(struct inotify_event) + event->len;
+                }
+            }
+        }
+
+        ok = pending_flush(&pending, queue, input_dir, output_dir, 0);
+    }
+
+    // Arquivos ainda em debounce são processados antes de encerrar
+    if (ok)
+        pending_flush(&pending, queue, input_dir, output_dir, 1);
+    while (pending.head)
+        pending_remove(&pending, pending.head);
+
+    pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+    sigaction(SIGINT, &old_int, NULL);
+    sigaction(SIGTERM, &old_term, NULL);
+    close(fd);
+    return 1;
+}
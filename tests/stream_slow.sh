@@ -0,0 +1,38 @@
+#!/bin/sh
+# Regressão: caminhos chegando devagar pela lista com --threads auto
+#
+# Com o controle de concorrência, apenas parte das trabalhadoras fica ativa.
+# Uma imagem inserida enquanto as demais estão suspensas não pode acordar só
+# uma trabalhadora acima do limite: o editor ficaria esperando para sempre.
+#
+# Uso: tests/stream_slow.sh [EDITOR]
+
+EDITOR=${1:-./bin/editor}
+IMAGES=$(dirname "$0")/../test_images
+WORK=$(mktemp -d) || exit 1
+trap 'rm -rf "$WORK"' EXIT
+
+mkdir "$WORK/in"
+for image in test1.jpg test5.jpg test16.jpg; do
+    cp "$IMAGES/$image" "$WORK/in/" || exit 1
+done
+
+(
+    for image in test1.jpg test5.jpg test16.jpg; do
+        echo "$WORK/in/$image"
+        sleep 1
+    done
+) | timeout 30 "$EDITOR" --files - --threads auto --filter grayscale >/dev/null
+status=$?
+
+if [ $status -eq 124 ]; then
+    echo "FALHA: o editor não terminou (imagem sem trabalhadora ativa)"
+    exit 1
+fi
+for image in test1.jpg test5.jpg test16.jpg; do
+    if [ ! -s "$WORK/in_grayscale/$image" ]; then
+        echo "FALHA: $image não foi processada (código $status)"
+        exit 1
+    fi
+done
+echo "OK: stream_slow"